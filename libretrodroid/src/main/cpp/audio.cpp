@@ -18,14 +18,16 @@
 #include "log.h"
 
 #include "audio.h"
+#include <algorithm>
 #include <cmath>
 #include <memory>
 
 namespace libretrodroid {
 
-Audio::Audio(int32_t sampleRate, double refreshRate, bool preferLowLatencyAudio) {
+Audio::Audio(int32_t sampleRate, double refreshRate, bool preferLowLatencyAudio, unsigned minimumLatencyMs) {
     LOGI("Audio initialization has been called with input sample rate %d", sampleRate);
 
+    this->minimumLatencyMs = minimumLatencyMs;
     contentRefreshRate = refreshRate;
     inputSampleRate = sampleRate;
     audioLatencySettings = findBestLatencySettings(preferLowLatencyAudio);
@@ -80,9 +82,43 @@ int32_t Audio::computeAudioBufferSize() {
     return roundToEven(inputSampleRate / sampleRateDivisor);
 }
 
+// The buffer is kept half full, so its average latency is half of the maximum one.
 double Audio::computeMaximumLatency() const {
     double maxLatency = (audioLatencySettings->bufferSizeInVideoFrames / contentRefreshRate) * 1000;
-    return std::max(maxLatency, 32.0);
+    return std::max({ maxLatency, 32.0, 2.0 * minimumLatencyMs });
+}
+
+void Audio::setMinimumLatency(unsigned milliseconds) {
+    if (milliseconds == minimumLatencyMs) return;
+    minimumLatencyMs = milliseconds;
+
+    // A larger buffer than requested is harmless, so we only rebuild the stream to grow it.
+    if (fifoBuffer && computeAudioBufferSize() <= (int32_t) fifoBuffer->getBufferCapacityInFrames()) {
+        return;
+    }
+
+    // The fifo is read by the stream callback, so it can only be replaced with the stream closed.
+    stream = nullptr;
+    latencyTuner = nullptr;
+    framesToSubmit = 0.0;
+    errorIntegral = 0.0;
+
+    std::unique_ptr<oboe::FifoBuffer> previousFifoBuffer = std::move(fifoBuffer);
+    if (!initializeStream()) {
+        fifoBuffer = std::move(previousFifoBuffer);
+        return;
+    }
+
+    // The new fifo is larger, so the buffered samples can be carried over and nothing is dropped.
+    if (previousFifoBuffer) {
+        int32_t bufferedFrames = previousFifoBuffer->getFullFramesAvailable();
+        previousFifoBuffer->read(temporaryAudioBuffer.get(), bufferedFrames);
+        fifoBuffer->write(temporaryAudioBuffer.get(), bufferedFrames);
+    }
+
+    if (startRequested) {
+        start();
+    }
 }
 
 void Audio::start() {
@@ -105,6 +141,21 @@ void Audio::setPlaybackSpeed(const double newPlaybackSpeed) {
     playbackSpeed = newPlaybackSpeed;
 }
 
+void Audio::setInputSampleRate(int32_t sampleRate, double refreshRate) {
+    if (sampleRate == inputSampleRate && refreshRate == contentRefreshRate) return;
+
+    LOGI("Audio input sample rate changed from %d to %d", inputSampleRate.load(), sampleRate);
+
+    inputSampleRate = sampleRate;
+    contentRefreshRate = refreshRate;
+
+    // The fifo keeps its size, the difference in latency is small and resizing it would drop the
+    // buffered samples. The integral term tracks the clock drift, which does not change.
+    if (stream != nullptr) {
+        baseConversionFactor = (double) inputSampleRate / stream->getSampleRate();
+    }
+}
+
 oboe::DataCallbackResult Audio::onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames) {
     double dynamicBufferFactor = computeDynamicBufferConversionFactor(0.001 * numFrames);
     double finalConversionFactor = baseConversionFactor * dynamicBufferFactor * playbackSpeed;
@@ -125,6 +176,15 @@ oboe::DataCallbackResult Audio::onAudioReady(oboe::AudioStream *oboeStream, void
     return oboe::DataCallbackResult::Continue;
 }
 
+double Audio::getBufferFillLevel() const {
+    // Without a stream there is nothing which could run out of samples.
+    if (!fifoBuffer) return 1.0;
+
+    double framesCapacityInBuffer = fifoBuffer->getBufferCapacityInFrames();
+    double framesAvailableInBuffer = fifoBuffer->getFullFramesAvailable();
+    return framesAvailableInBuffer / framesCapacityInBuffer;
+}
+
 // To prevent audio buffer overruns or underruns we set up a PI controller. The idea is to run the
 // audio slower when the buffer is empty and faster when it's full.
 double Audio::computeDynamicBufferConversionFactor(double dt) {
@@ -19,6 +19,7 @@
 #define LIBRETRODROID_AUDIO_H
 
 #include <array>
+#include <atomic>
 #include <unistd.h>
 #include <oboe/Oboe.h>
 #include <oboe/FifoBuffer.h>
@@ -38,7 +39,7 @@ private:
     const AudioLatencySettings LOW_LATENCY_SETTINGS { 4, true };
 
 public:
-    Audio(int32_t sampleRate, double refreshRate, bool preferLowLatencyAudio);
+    Audio(int32_t sampleRate, double refreshRate, bool preferLowLatencyAudio, unsigned minimumLatencyMs = 0);
     ~Audio() override = default;
 
     void start();
@@ -56,6 +57,18 @@ public:
     void write(const int16_t *data, size_t frames);
     void setPlaybackSpeed(const double newPlaybackSpeed);
 
+    // Changes the rate of the incoming samples while the stream keeps playing. Buffered samples
+    // are kept and played at the new rate.
+    void setInputSampleRate(int32_t sampleRate, double refreshRate);
+
+    // Grows the buffer so that its average latency is at least the given one. The stream is only
+    // rebuilt when the buffer has to grow, buffered samples are kept. It must be called by the
+    // thread which writes the samples.
+    void setMinimumLatency(unsigned milliseconds);
+
+    // Fraction of the buffer currently filled with samples, from 0 to 1.
+    double getBufferFillLevel() const;
+
 private:
     static int32_t roundToEven(int32_t x);
     double computeDynamicBufferConversionFactor(double dt);
@@ -78,10 +91,12 @@ private:
     std::unique_ptr<oboe::LatencyTuner> latencyTuner = nullptr;
 
     bool startRequested = false;
-    int32_t inputSampleRate;
-    double contentRefreshRate = 60.0;
+    // Changed by the thread running the core, while stream error recovery runs on an oboe thread.
+    std::atomic<int32_t> inputSampleRate { 0 };
+    std::atomic<double> contentRefreshRate { 60.0 };
+    unsigned minimumLatencyMs = 0;
 
-    double baseConversionFactor = 1.0;
+    std::atomic<double> baseConversionFactor { 1.0 };
 
     double framesToSubmit = 0.0;
     double errorIntegral = 0.0;
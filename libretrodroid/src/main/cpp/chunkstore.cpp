@@ -0,0 +1,752 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <functional>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "chunkstore.h"
+#include "utils/utils.h"
+#include "log.h"
+
+namespace libretrodroid {
+
+static const char MANIFEST_MAGIC[4] = { 'L', 'R', 'D', 'M' };
+static constexpr uint32_t MANIFEST_VERSION = 1;
+static constexpr uint32_t MAX_MANIFEST_CHUNKS = 1 << 24;
+
+// Packs start with the magic and the version, followed by records made of the chunk hash, its raw
+// size and its stored size, then the stored data. Data is compressed only if it gets smaller.
+static const char PACK_MAGIC[4] = { 'L', 'R', 'D', 'P' };
+static constexpr uint32_t PACK_VERSION = 1;
+static constexpr size_t PACK_HEADER_SIZE = sizeof(PACK_MAGIC) + sizeof(PACK_VERSION);
+static constexpr size_t RECORD_HEADER_SIZE = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+// Chunk size bounds, FastCDC normalizes the cut points around the average size.
+static constexpr size_t MIN_CHUNK_SIZE = 2 * 1024;
+static constexpr size_t AVERAGE_CHUNK_SIZE = 8 * 1024;
+static constexpr size_t MAX_CHUNK_SIZE = 64 * 1024;
+static constexpr uint64_t MASK_SMALL = 0x0003590703530000ULL;
+static constexpr uint64_t MASK_LARGE = 0x0000d90003530000ULL;
+
+static constexpr const char* SLOTS_DIRECTORY = "/slots";
+static constexpr const char* PACKS_DIRECTORY = "/packs";
+static constexpr const char* PACK_SUFFIX = ".pack";
+static constexpr const char* TEMP_SUFFIX = ".tmp";
+
+struct GearTable {
+    uint64_t values[256];
+
+    GearTable() {
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+        for (uint64_t& value : values) {
+            state += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            value = z ^ (z >> 31);
+        }
+    }
+};
+
+static const GearTable GEAR;
+
+static inline uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t finalizeHash(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+static bool makeDirectory(const std::string& path) {
+    return mkdir(path.c_str(), 0700) == 0 || errno == EEXIST;
+}
+
+static bool readWholeFile(const std::string& path, std::vector<uint8_t>& output) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat fileStat {};
+    bool result = fstat(fd, &fileStat) == 0;
+    if (result) {
+        output.resize(fileStat.st_size);
+        result = Utils::readFully(fd, output.data(), output.size());
+    }
+
+    close(fd);
+    return result;
+}
+
+// Data is written to a temporary file which replaces the destination, so readers never observe
+// partially written files.
+static bool writeFileAtomically(const std::string& path, const void* data, size_t size) {
+    std::string tempPath = path + TEMP_SUFFIX;
+
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+
+    bool result = Utils::writeFully(fd, data, size) && fdatasync(fd) == 0;
+    result = close(fd) == 0 && result;
+    result = result && rename(tempPath.c_str(), path.c_str()) == 0;
+
+    if (!result) {
+        LOGE("Cannot write %s: %s", path.c_str(), strerror(errno));
+        unlink(tempPath.c_str());
+    }
+    return result;
+}
+
+static bool preadFully(int fd, void* data, size_t size, uint64_t offset) {
+    auto* output = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        ssize_t count = pread(fd, output, size, (off_t) offset);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+
+        output += count;
+        offset += count;
+        size -= count;
+    }
+    return true;
+}
+
+static int createPackFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return -1;
+
+    uint8_t header[PACK_HEADER_SIZE];
+    memcpy(header, PACK_MAGIC, sizeof(PACK_MAGIC));
+    memcpy(header + sizeof(PACK_MAGIC), &PACK_VERSION, sizeof(PACK_VERSION));
+
+    if (!Utils::writeFully(fd, header, sizeof(header))) {
+        close(fd);
+        unlink(path.c_str());
+        return -1;
+    }
+    return fd;
+}
+
+static void encodeRecordHeader(uint8_t* output, uint64_t low, uint64_t high, uint32_t rawSize, uint32_t storedSize) {
+    memcpy(output, &low, sizeof(low));
+    memcpy(output + 8, &high, sizeof(high));
+    memcpy(output + 16, &rawSize, sizeof(rawSize));
+    memcpy(output + 20, &storedSize, sizeof(storedSize));
+}
+
+static void forEachDirectoryEntry(const std::string& path, const std::function<void(const std::string&)>& lambda) {
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) return;
+
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+        lambda(name);
+    }
+
+    closedir(dir);
+}
+
+static std::string toHex(uint64_t value) {
+    static const char DIGITS[] = "0123456789abcdef";
+    std::string result(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        result[i] = DIGITS[value & 0xF];
+        value >>= 4;
+    }
+    return result;
+}
+
+static std::optional<uint64_t> fromHex(const std::string& value) {
+    if (value.size() != 16) return std::nullopt;
+
+    uint64_t result = 0;
+    for (char c : value) {
+        result <<= 4;
+        if (c >= '0' && c <= '9') result |= c - '0';
+        else if (c >= 'a' && c <= 'f') result |= c - 'a' + 10;
+        else return std::nullopt;
+    }
+    return result;
+}
+
+ChunkStore::ChunkStore(std::string directory) : directory(std::move(directory)) { }
+
+bool ChunkStore::open() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    bool directoriesCreated = makeDirectory(directory) &&
+        makeDirectory(directory + SLOTS_DIRECTORY) &&
+        makeDirectory(directory + PACKS_DIRECTORY);
+
+    if (!directoriesCreated) {
+        LOGE("Cannot create state store in %s: %s", directory.c_str(), strerror(errno));
+        return false;
+    }
+
+    references.clear();
+    locations.clear();
+    nextPack = 0;
+
+    std::vector<uint64_t> packs = listPacks();
+    for (uint64_t pack : packs) {
+        nextPack = std::max(nextPack, pack + 1);
+        for (const PackRecord& record : scanPack(pack)) {
+            locations.emplace(record.hash, record.location);
+        }
+    }
+
+    forEachDirectoryEntry(directory + SLOTS_DIRECTORY, [&](const std::string& name) {
+        if (!isValidSlotName(name)) return;
+
+        auto manifest = readManifest(slotPath(name));
+        if (manifest.has_value()) {
+            addReferences(manifest.value(), 1);
+        } else {
+            LOGW("Ignoring corrupted state slot %s", name.c_str());
+        }
+    });
+
+    LOGI("Opened state store with %zu chunks in %zu packs", locations.size(), packs.size());
+    return true;
+}
+
+bool ChunkStore::writeSlot(const std::string& slot, const int8_t* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!isValidSlotName(slot)) {
+        LOGE("Invalid slot name: %s", slot.c_str());
+        return false;
+    }
+
+    Manifest manifest;
+    manifest.stateSize = size;
+
+    auto* input = reinterpret_cast<const uint8_t*>(data);
+    std::vector<Hash> newChunks;
+
+    uint64_t pack = nextPack;
+    uint64_t packOffset = PACK_HEADER_SIZE;
+    int packFd = -1;
+    bool result = true;
+
+    // Chunks already in the store are trusted by hash, only new ones are appended to the pack.
+    for (size_t offset = 0; offset < size;) {
+        size_t chunkSize = findCutPoint(input + offset, size - offset);
+        Hash hash = hashChunk(input + offset, chunkSize);
+
+        if (locations.find(hash) == locations.end()) {
+            if (packFd < 0) {
+                packFd = createPackFile(packPath(pack));
+                nextPack++;
+            }
+
+            if (packFd < 0 || !appendChunk(packFd, pack, packOffset, hash, input + offset, chunkSize)) {
+                result = false;
+                break;
+            }
+            newChunks.push_back(hash);
+        }
+
+        manifest.chunks.push_back(ChunkRef { hash, (uint32_t) chunkSize });
+        offset += chunkSize;
+    }
+
+    // A single sync makes the whole pack durable before any manifest references it.
+    if (packFd >= 0) {
+        result = result && fdatasync(packFd) == 0;
+        result = close(packFd) == 0 && result;
+    }
+
+    if (!result) {
+        LOGE("Cannot write chunks of slot %s: %s", slot.c_str(), strerror(errno));
+        for (const Hash& hash : newChunks) {
+            locations.erase(hash);
+        }
+        if (packFd >= 0) {
+            unlink(packPath(pack).c_str());
+        }
+        return false;
+    }
+
+    // Chunks are written before the manifest which references them, so a crash can only leave
+    // unreferenced chunks behind.
+    std::optional<Manifest> previous = readManifest(slotPath(slot));
+    if (!writeManifest(slotPath(slot), manifest)) {
+        return false;
+    }
+
+    if (previous.has_value()) {
+        addReferences(previous.value(), -1);
+    }
+    addReferences(manifest, 1);
+
+    LOGD("Stored slot %s with %zu chunks, %zu new", slot.c_str(), manifest.chunks.size(), newChunks.size());
+    return true;
+}
+
+std::optional<size_t> ChunkStore::getSlotSize(const std::string& slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!isValidSlotName(slot)) return std::nullopt;
+
+    auto manifest = readManifest(slotPath(slot));
+    if (!manifest.has_value()) return std::nullopt;
+
+    return manifest->stateSize;
+}
+
+bool ChunkStore::readSlot(const std::string& slot, int8_t* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!isValidSlotName(slot)) return false;
+
+    auto manifest = readManifest(slotPath(slot));
+    if (!manifest.has_value() || manifest->stateSize != size) {
+        LOGE("Cannot read slot %s", slot.c_str());
+        return false;
+    }
+
+    // Consecutive chunks mostly come from the same few packs, which are kept open until the end.
+    std::unordered_map<uint64_t, int> packFds;
+    auto* output = reinterpret_cast<uint8_t*>(data);
+    bool result = true;
+
+    for (const ChunkRef& chunk : manifest->chunks) {
+        auto location = locations.find(chunk.hash);
+        result = location != locations.end() && location->second.rawSize == chunk.size;
+
+        if (result) {
+            auto packFd = packFds.find(location->second.pack);
+            if (packFd == packFds.end()) {
+                int fd = ::open(packPath(location->second.pack).c_str(), O_RDONLY | O_CLOEXEC);
+                packFd = packFds.emplace(location->second.pack, fd).first;
+            }
+            result = packFd->second >= 0 && readChunk(packFd->second, chunk.hash, location->second, output);
+        }
+
+        if (!result) {
+            LOGE("Slot %s references a missing or corrupted chunk", slot.c_str());
+            break;
+        }
+        output += chunk.size;
+    }
+
+    for (auto& [pack, fd] : packFds) {
+        if (fd >= 0) close(fd);
+    }
+
+    return result;
+}
+
+bool ChunkStore::deleteSlot(const std::string& slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!isValidSlotName(slot)) return false;
+
+    std::string path = slotPath(slot);
+    auto manifest = readManifest(path);
+
+    if (unlink(path.c_str()) != 0) {
+        return false;
+    }
+
+    if (manifest.has_value()) {
+        addReferences(manifest.value(), -1);
+    }
+    return true;
+}
+
+std::vector<std::string> ChunkStore::listSlots() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<std::string> result;
+    forEachDirectoryEntry(directory + SLOTS_DIRECTORY, [&](const std::string& name) {
+        if (isValidSlotName(name)) {
+            result.push_back(name);
+        }
+    });
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Packs on disk are scanned instead of the index, so this also removes chunks which were left
+// behind by an interrupted write. Packs without live chunks are deleted, mostly dead ones are
+// rewritten with their live chunks only. Returns the number of removed chunks.
+size_t ChunkStore::collectGarbage() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t result = 0;
+    for (uint64_t pack : listPacks()) {
+        std::vector<PackRecord> records = scanPack(pack);
+        std::vector<PackRecord> liveRecords;
+
+        uint64_t totalBytes = 0;
+        uint64_t liveBytes = 0;
+        for (const PackRecord& record : records) {
+            uint64_t recordBytes = RECORD_HEADER_SIZE + record.location.storedSize;
+            totalBytes += recordBytes;
+            if (isLive(record)) {
+                liveRecords.push_back(record);
+                liveBytes += recordBytes;
+            }
+        }
+
+        bool empty = liveRecords.empty();
+        if (!empty && (liveRecords.size() == records.size() || 2 * liveBytes > totalBytes)) continue;
+        if (!empty && !repack(pack, liveRecords)) continue;
+        if (unlink(packPath(pack).c_str()) != 0) continue;
+
+        for (const PackRecord& record : records) {
+            if (isLive(record)) continue;
+
+            auto location = locations.find(record.hash);
+            if (location != locations.end() && location->second.pack == pack) {
+                locations.erase(location);
+                references.erase(record.hash);
+            }
+        }
+        result += records.size() - liveRecords.size();
+    }
+
+    LOGI("Collected %zu unreferenced chunks", result);
+    return result;
+}
+
+// Murmur3 style 128 bit hash, processing 16 bytes per iteration.
+ChunkStore::Hash ChunkStore::hashChunk(const uint8_t* data, size_t size) {
+    const uint64_t c1 = 0x87C37B91114253D5ULL;
+    const uint64_t c2 = 0x4CF5AD432745937FULL;
+
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+
+    auto mix = [&](uint64_t k1, uint64_t k2) {
+        k1 *= c1; k1 = rotateLeft(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotateLeft(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52DCE729;
+
+        k2 *= c2; k2 = rotateLeft(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotateLeft(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495AB5;
+    };
+
+    size_t blocks = size / 16;
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t k[2];
+        memcpy(k, data + i * 16, sizeof(k));
+        mix(k[0], k[1]);
+    }
+
+    uint64_t tail[2] = { 0, 0 };
+    memcpy(tail, data + blocks * 16, size % 16);
+    mix(tail[0], tail[1]);
+
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = finalizeHash(h1);
+    h2 = finalizeHash(h2);
+    h1 += h2;
+    h2 += h1;
+
+    return Hash { h1, h2 };
+}
+
+// FastCDC: a gear rolling hash looks for cut points, with a stricter mask before the average size
+// and a looser one after it, which keeps chunk sizes close to the average.
+size_t ChunkStore::findCutPoint(const uint8_t* data, size_t size) {
+    if (size <= MIN_CHUNK_SIZE) return size;
+
+    size_t limit = std::min(size, MAX_CHUNK_SIZE);
+    size_t normal = std::min(limit, AVERAGE_CHUNK_SIZE);
+
+    uint64_t fingerprint = 0;
+    size_t i = MIN_CHUNK_SIZE;
+
+    for (; i < normal; i++) {
+        fingerprint = (fingerprint << 1) + GEAR.values[data[i]];
+        if ((fingerprint & MASK_SMALL) == 0) return i + 1;
+    }
+
+    for (; i < limit; i++) {
+        fingerprint = (fingerprint << 1) + GEAR.values[data[i]];
+        if ((fingerprint & MASK_LARGE) == 0) return i + 1;
+    }
+
+    return limit;
+}
+
+bool ChunkStore::isValidSlotName(const std::string& slot) {
+    if (slot.empty() || slot.size() > 128 || slot[0] == '.') return false;
+
+    return std::all_of(slot.begin(), slot.end(), [](char c) {
+        return isalnum((unsigned char) c) || c == '_' || c == '-' || c == '.';
+    }) && slot.find(TEMP_SUFFIX) == std::string::npos;
+}
+
+bool ChunkStore::isLive(const PackRecord& record) const {
+    auto location = locations.find(record.hash);
+    if (location == locations.end()) return false;
+    if (location->second.pack != record.location.pack || location->second.offset != record.location.offset) return false;
+
+    auto reference = references.find(record.hash);
+    return reference != references.end() && reference->second > 0;
+}
+
+std::string ChunkStore::slotPath(const std::string& slot) const {
+    return directory + SLOTS_DIRECTORY + "/" + slot;
+}
+
+std::string ChunkStore::packPath(uint64_t pack) const {
+    return directory + PACKS_DIRECTORY + "/" + toHex(pack) + PACK_SUFFIX;
+}
+
+std::vector<uint64_t> ChunkStore::listPacks() const {
+    std::vector<uint64_t> result;
+    size_t suffixLength = strlen(PACK_SUFFIX);
+
+    forEachDirectoryEntry(directory + PACKS_DIRECTORY, [&](const std::string& name) {
+        if (name.size() != 16 + suffixLength || name.compare(16, suffixLength, PACK_SUFFIX) != 0) return;
+
+        auto pack = fromHex(name.substr(0, 16));
+        if (pack.has_value()) {
+            result.push_back(pack.value());
+        }
+    });
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<ChunkStore::PackRecord> ChunkStore::scanPack(uint64_t pack) const {
+    std::vector<PackRecord> result;
+
+    int fd = ::open(packPath(pack).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return result;
+
+    struct stat fileStat {};
+    uint8_t header[std::max(PACK_HEADER_SIZE, RECORD_HEADER_SIZE)];
+
+    bool valid = fstat(fd, &fileStat) == 0 &&
+        preadFully(fd, header, PACK_HEADER_SIZE, 0) &&
+        memcmp(header, PACK_MAGIC, sizeof(PACK_MAGIC)) == 0 &&
+        memcmp(header + sizeof(PACK_MAGIC), &PACK_VERSION, sizeof(PACK_VERSION)) == 0;
+
+    auto fileSize = (uint64_t) fileStat.st_size;
+    uint64_t offset = PACK_HEADER_SIZE;
+
+    while (valid && offset + RECORD_HEADER_SIZE <= fileSize) {
+        if (!preadFully(fd, header, RECORD_HEADER_SIZE, offset)) break;
+
+        PackRecord record {};
+        memcpy(&record.hash.low, header, sizeof(uint64_t));
+        memcpy(&record.hash.high, header + 8, sizeof(uint64_t));
+        memcpy(&record.location.rawSize, header + 16, sizeof(uint32_t));
+        memcpy(&record.location.storedSize, header + 20, sizeof(uint32_t));
+        record.location.pack = pack;
+        record.location.offset = offset + RECORD_HEADER_SIZE;
+
+        bool validSizes = record.location.rawSize > 0 &&
+            record.location.rawSize <= MAX_CHUNK_SIZE &&
+            record.location.storedSize > 0 &&
+            record.location.storedSize <= record.location.rawSize;
+
+        if (!validSizes || record.location.offset + record.location.storedSize > fileSize) {
+            LOGW("Ignoring truncated pack %s after %llu bytes", packPath(pack).c_str(), (unsigned long long) offset);
+            break;
+        }
+
+        result.push_back(record);
+        offset = record.location.offset + record.location.storedSize;
+    }
+
+    close(fd);
+    return result;
+}
+
+std::optional<ChunkStore::Manifest> ChunkStore::readManifest(const std::string& path) const {
+    std::vector<uint8_t> content;
+    if (!readWholeFile(path, content)) return std::nullopt;
+
+    const size_t headerSize = sizeof(MANIFEST_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t);
+    const size_t entrySize = 2 * sizeof(uint64_t) + sizeof(uint32_t);
+
+    if (content.size() < headerSize || memcmp(content.data(), MANIFEST_MAGIC, sizeof(MANIFEST_MAGIC)) != 0) {
+        return std::nullopt;
+    }
+
+    const uint8_t* input = content.data() + sizeof(MANIFEST_MAGIC);
+    auto read = [&](void* value, size_t size) {
+        memcpy(value, input, size);
+        input += size;
+    };
+
+    uint32_t version;
+    uint32_t count;
+    Manifest result;
+
+    read(&version, sizeof(version));
+    read(&result.stateSize, sizeof(result.stateSize));
+    read(&count, sizeof(count));
+
+    if (version != MANIFEST_VERSION || count > MAX_MANIFEST_CHUNKS || content.size() != headerSize + count * entrySize) {
+        return std::nullopt;
+    }
+
+    uint64_t totalSize = 0;
+    result.chunks.resize(count);
+    for (ChunkRef& chunk : result.chunks) {
+        read(&chunk.hash.low, sizeof(uint64_t));
+        read(&chunk.hash.high, sizeof(uint64_t));
+        read(&chunk.size, sizeof(uint32_t));
+        totalSize += chunk.size;
+    }
+
+    if (totalSize != result.stateSize) return std::nullopt;
+
+    return result;
+}
+
+bool ChunkStore::writeManifest(const std::string& path, const Manifest& manifest) const {
+    std::vector<uint8_t> content;
+    auto append = [&](const void* value, size_t size) {
+        auto* bytes = (const uint8_t*) value;
+        content.insert(content.end(), bytes, bytes + size);
+    };
+
+    auto count = (uint32_t) manifest.chunks.size();
+
+    append(MANIFEST_MAGIC, sizeof(MANIFEST_MAGIC));
+    append(&MANIFEST_VERSION, sizeof(MANIFEST_VERSION));
+    append(&manifest.stateSize, sizeof(manifest.stateSize));
+    append(&count, sizeof(count));
+
+    for (const ChunkRef& chunk : manifest.chunks) {
+        append(&chunk.hash.low, sizeof(uint64_t));
+        append(&chunk.hash.high, sizeof(uint64_t));
+        append(&chunk.size, sizeof(uint32_t));
+    }
+
+    return writeFileAtomically(path, content.data(), content.size());
+}
+
+bool ChunkStore::appendChunk(int fd, uint64_t pack, uint64_t& offset, const Hash& hash, const uint8_t* data, size_t size) {
+    chunkBuffer.resize(RECORD_HEADER_SIZE + compressBound(size));
+
+    uLongf compressedSize = chunkBuffer.size() - RECORD_HEADER_SIZE;
+    int status = compress2(chunkBuffer.data() + RECORD_HEADER_SIZE, &compressedSize, data, size, Z_BEST_SPEED);
+
+    size_t storedSize = status == Z_OK && compressedSize < size ? compressedSize : size;
+    if (storedSize == size) {
+        memcpy(chunkBuffer.data() + RECORD_HEADER_SIZE, data, size);
+    }
+
+    encodeRecordHeader(chunkBuffer.data(), hash.low, hash.high, (uint32_t) size, (uint32_t) storedSize);
+    if (!Utils::writeFully(fd, chunkBuffer.data(), RECORD_HEADER_SIZE + storedSize)) {
+        return false;
+    }
+
+    locations[hash] = ChunkLocation { pack, offset + RECORD_HEADER_SIZE, (uint32_t) storedSize, (uint32_t) size };
+    offset += RECORD_HEADER_SIZE + storedSize;
+    return true;
+}
+
+bool ChunkStore::readChunk(int fd, const Hash& hash, const ChunkLocation& location, uint8_t* data) {
+    chunkBuffer.resize(location.storedSize);
+    if (!preadFully(fd, chunkBuffer.data(), location.storedSize, location.offset)) {
+        return false;
+    }
+
+    if (location.storedSize == location.rawSize) {
+        memcpy(data, chunkBuffer.data(), location.rawSize);
+    } else {
+        uLongf decompressedSize = location.rawSize;
+        int status = uncompress(data, &decompressedSize, chunkBuffer.data(), location.storedSize);
+        if (status != Z_OK || decompressedSize != location.rawSize) return false;
+    }
+
+    // Protects against corrupted packs.
+    return hashChunk(data, location.rawSize) == hash;
+}
+
+// The live chunks are copied as they are into a new pack, which is synced before the old one can
+// be deleted.
+bool ChunkStore::repack(uint64_t pack, const std::vector<PackRecord>& liveRecords) {
+    int sourceFd = ::open(packPath(pack).c_str(), O_RDONLY | O_CLOEXEC);
+    if (sourceFd < 0) return false;
+
+    uint64_t newPack = nextPack++;
+    int fd = createPackFile(packPath(newPack));
+
+    std::vector<PackRecord> newRecords;
+    uint64_t offset = PACK_HEADER_SIZE;
+    bool result = fd >= 0;
+
+    for (const PackRecord& record : liveRecords) {
+        if (!result) break;
+
+        const ChunkLocation& location = record.location;
+        chunkBuffer.resize(RECORD_HEADER_SIZE + location.storedSize);
+        encodeRecordHeader(chunkBuffer.data(), record.hash.low, record.hash.high, location.rawSize, location.storedSize);
+
+        result = preadFully(sourceFd, chunkBuffer.data() + RECORD_HEADER_SIZE, location.storedSize, location.offset) &&
+            Utils::writeFully(fd, chunkBuffer.data(), chunkBuffer.size());
+
+        newRecords.push_back(PackRecord { record.hash, { newPack, offset + RECORD_HEADER_SIZE, location.storedSize, location.rawSize } });
+        offset += chunkBuffer.size();
+    }
+
+    close(sourceFd);
+    if (fd >= 0) {
+        result = result && fdatasync(fd) == 0;
+        result = close(fd) == 0 && result;
+    }
+
+    if (!result) {
+        LOGE("Cannot repack %s: %s", packPath(pack).c_str(), strerror(errno));
+        unlink(packPath(newPack).c_str());
+        return false;
+    }
+
+    for (const PackRecord& record : newRecords) {
+        locations[record.hash] = record.location;
+    }
+    return true;
+}
+
+void ChunkStore::addReferences(const Manifest& manifest, int delta) {
+    for (const ChunkRef& chunk : manifest.chunks) {
+        uint32_t& count = references[chunk.hash];
+        count = delta > 0 ? count + delta : std::max<int64_t>((int64_t) count + delta, 0);
+    }
+}
+
+} //namespace libretrodroid
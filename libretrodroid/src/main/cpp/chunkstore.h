@@ -0,0 +1,135 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_CHUNKSTORE_H
+#define LIBRETRODROID_CHUNKSTORE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libretrodroid {
+
+// Content addressed storage for save states. States are split in content defined chunks, so that
+// similar states share most of them even when data moves around, and each chunk is stored once.
+//
+// The directory contains:
+//   slots/<name>              manifest listing the chunks of a state
+//   packs/<id>.pack           chunks added by a single write, compressed when it helps
+// New chunks of a slot are appended to a fresh pack, which is synced once before the manifest is
+// replaced. Chunks are identified by their 128 bit hash and never read back to be compared.
+// The chunk index and the reference counts are rebuilt from the packs and the manifests when the
+// store is opened, so that they can never go out of sync with the files on disk. Unreferenced
+// chunks are only deleted by collectGarbage(), which drops or repacks the packs containing them.
+class ChunkStore {
+public:
+    explicit ChunkStore(std::string directory);
+
+    ChunkStore(ChunkStore const&) = delete;
+    void operator=(ChunkStore const&) = delete;
+
+    bool open();
+
+    bool writeSlot(const std::string& slot, const int8_t* data, size_t size);
+    std::optional<size_t> getSlotSize(const std::string& slot);
+
+    // Assembles the slot directly into the given memory, which must hold getSlotSize() bytes.
+    bool readSlot(const std::string& slot, int8_t* data, size_t size);
+
+    bool deleteSlot(const std::string& slot);
+    std::vector<std::string> listSlots();
+
+    // Deletes chunks which are not referenced by any slot. Returns the number of deleted chunks.
+    size_t collectGarbage();
+
+private:
+    struct Hash {
+        uint64_t low;
+        uint64_t high;
+
+        bool operator==(const Hash& other) const {
+            return low == other.low && high == other.high;
+        }
+    };
+
+    struct HashHasher {
+        size_t operator()(const Hash& hash) const {
+            return (size_t) hash.low;
+        }
+    };
+
+    struct ChunkRef {
+        Hash hash;
+        uint32_t size;
+    };
+
+    // Position of the chunk payload inside its pack.
+    struct ChunkLocation {
+        uint64_t pack;
+        uint64_t offset;
+        uint32_t storedSize;
+        uint32_t rawSize;
+    };
+
+    struct PackRecord {
+        Hash hash;
+        ChunkLocation location;
+    };
+
+    struct Manifest {
+        uint64_t stateSize = 0;
+        std::vector<ChunkRef> chunks;
+    };
+
+    static Hash hashChunk(const uint8_t* data, size_t size);
+    static size_t findCutPoint(const uint8_t* data, size_t size);
+    static bool isValidSlotName(const std::string& slot);
+
+    std::string slotPath(const std::string& slot) const;
+    std::string packPath(uint64_t pack) const;
+
+    std::optional<Manifest> readManifest(const std::string& path) const;
+    bool writeManifest(const std::string& path, const Manifest& manifest) const;
+
+    // Stops at the first truncated or invalid record, which can be left behind by a crash.
+    std::vector<PackRecord> scanPack(uint64_t pack) const;
+    std::vector<uint64_t> listPacks() const;
+
+    bool appendChunk(int fd, uint64_t pack, uint64_t& offset, const Hash& hash, const uint8_t* data, size_t size);
+    bool readChunk(int fd, const Hash& hash, const ChunkLocation& location, uint8_t* data);
+    bool repack(uint64_t pack, const std::vector<PackRecord>& liveRecords);
+
+    void addReferences(const Manifest& manifest, int delta);
+    bool isLive(const PackRecord& record) const;
+
+private:
+    std::mutex mutex;
+    std::string directory;
+    std::unordered_map<Hash, uint32_t, HashHasher> references;
+    std::unordered_map<Hash, ChunkLocation, HashHasher> locations;
+    uint64_t nextPack = 0;
+    std::vector<uint8_t> chunkBuffer;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_CHUNKSTORE_H
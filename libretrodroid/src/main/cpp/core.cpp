@@ -16,14 +16,23 @@
  */
 
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <stdexcept>
 #include "core.h"
 
+#ifndef __ANDROID__
+#include <sys/mman.h>
+#endif
+
 #include "log.h"
+#include "utils/utils.h"
 
 namespace libretrodroid {
 
-Core::Core(const std::string& soCorePath) {
-    open(soCorePath);
+Core::Core(const std::string& soCorePath, bool privateCopy) {
+    open(soCorePath, privateCopy);
 }
 
 void* get_symbol(void* handle, const char* symbol) {
@@ -35,8 +44,67 @@ void* get_symbol(void* handle, const char* symbol) {
     return result;
 }
 
-void Core::open(const std::string& soCorePath) {
-    libHandle = dlopen(soCorePath.c_str(), RTLD_LOCAL | RTLD_LAZY);
+#ifdef __ANDROID__
+
+// Only the headless tools run several instances of the same core. On Android it would need
+// ANDROID_DLEXT_FORCE_LOAD, which is not available on every supported API level.
+void* Core::openPrivateCopy(const std::string& soCorePath) {
+    LOGE("Private copies of %s are not supported on Android", soCorePath.c_str());
+    return nullptr;
+}
+
+#else
+
+// The dynamic loader recognizes libraries by path and inode, so every copy is loaded from its own
+// anonymous file. The file is kept open until the core is closed, otherwise another copy could
+// reuse the descriptor and therefore the path.
+void* Core::openPrivateCopy(const std::string& soCorePath) {
+    int source = ::open(soCorePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (source < 0) {
+        return nullptr;
+    }
+
+    int copy = memfd_create("libretro-core", MFD_CLOEXEC);
+    if (copy < 0) {
+        ::close(source);
+        return nullptr;
+    }
+
+    char buffer[64 * 1024];
+    ssize_t count;
+    bool copied = true;
+    while ((count = read(source, buffer, sizeof(buffer))) != 0) {
+        if (count < 0 || !Utils::writeFully(copy, buffer, (size_t) count)) {
+            copied = false;
+            break;
+        }
+    }
+    ::close(source);
+
+    void* result = nullptr;
+    if (copied) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/fd/%d", copy);
+        result = dlopen(path, RTLD_LOCAL | RTLD_LAZY);
+    }
+
+    if (result) {
+        privateCopyFd = copy;
+    } else {
+        ::close(copy);
+    }
+    return result;
+}
+
+#endif
+
+void Core::open(const std::string& soCorePath, bool privateCopy) {
+    if (privateCopy) {
+        libHandle = openPrivateCopy(soCorePath);
+    } else {
+        libHandle = dlopen(soCorePath.c_str(), RTLD_LOCAL | RTLD_LAZY);
+    }
+
     if (!libHandle) {
         LOGE("Cannot dlopen library, closing");
         throw std::runtime_error("Cannot dlopen library");
@@ -71,6 +139,10 @@ void Core::close() {
         dlclose(libHandle);
         libHandle = nullptr;
     }
+    if (privateCopyFd >= 0) {
+        ::close(privateCopyFd);
+        privateCopyFd = -1;
+    }
 }
 
 Core::~Core() {
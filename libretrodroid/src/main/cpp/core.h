@@ -50,14 +50,19 @@ public:
     void (*retro_set_input_poll)(retro_input_poll_t);
     void (*retro_set_input_state)(retro_input_state_t);
 
-    Core(const std::string& soCorePath);
+    // A private copy does not share any global state with other instances of the same core, which
+    // are otherwise the same library mapped once in the process. Only available on desktop hosts.
+    explicit Core(const std::string& soCorePath, bool privateCopy = false);
     ~Core();
 
 private:
-    void open(const std::string& soCorePath);
+    void open(const std::string& soCorePath, bool privateCopy);
     void close();
 
+    void* openPrivateCopy(const std::string& soCorePath);
+
     void* libHandle = nullptr;
+    int privateCopyFd = -1;
 };
 
 }
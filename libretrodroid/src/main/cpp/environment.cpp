@@ -24,12 +24,13 @@
 #include <cmath>
 #include <EGL/egl.h>
 #include <unordered_map>
+#include <algorithm>
 
 #include "../../libretro-common/include/libretro.h"
 #include "log.h"
 #include "environment.h"
 #include "vfs/vfs.h"
-#include "microphone/microphoneinterface.h"
+#include "perfcounters.h"
 
 void Environment::initialize(
     const std::string &requiredSystemDirectory,
@@ -59,12 +60,24 @@ void Environment::deinitialize() {
     bottomLeftOrigin = false;
     screenRotation = 0;
 
-    gameGeometryUpdated = false;
     gameGeometryWidth = 0;
     gameGeometryHeight = 0;
     gameGeometryAspectRatio = -1.0f;
+    gameTiming = libretrodroid::EnvironmentEvent::Timing {};
 
     rumbleStates.fill(libretrodroid::RumbleState {});
+
+    drainEvents([](libretrodroid::EnvironmentEvent&) { });
+    eventsOverflowed = false;
+
+    audioVideoEnable = AUDIO_VIDEO_ENABLE_VIDEO | AUDIO_VIDEO_ENABLE_AUDIO;
+    serializationQuirks = 0;
+
+    throttleState = { RETRO_THROTTLE_NONE, 0.0f };
+    targetRefreshRate = 60.0f;
+    fastForwardingOverride = { 0.0f, false, false, false };
+    minimumAudioLatency = 0;
+    audioBufferStatusCallback = nullptr;
 }
 
 void Environment::updateVariable(const std::string& key, const std::string& value) {
@@ -170,11 +183,26 @@ bool Environment::environment_handle_get_vfs_interface(struct retro_vfs_interfac
 }
 
 bool Environment::environment_handle_get_microphone_interface(struct retro_microphone_interface* microphone_interface) {
-    if (!enableMicrophone) {
+    if (!enableMicrophone || microphoneInterface == nullptr) {
         return false;
     }
 
-    *microphone_interface = *libretrodroid::MicrophoneInterface::getInterface();
+    *microphone_interface = *microphoneInterface;
+    return true;
+}
+
+bool Environment::environment_handle_set_serialization_quirks(uint64_t* quirks) {
+    serializationQuirks = *quirks;
+
+    uint64_t supportedQuirks = RETRO_SERIALIZATION_QUIRK_INCOMPLETE
+        | RETRO_SERIALIZATION_QUIRK_MUST_INITIALIZE
+        | RETRO_SERIALIZATION_QUIRK_CORE_VARIABLE_SIZE
+        | RETRO_SERIALIZATION_QUIRK_SINGLE_SESSION
+        | RETRO_SERIALIZATION_QUIRK_ENDIAN_DEPENDENT
+        | RETRO_SERIALIZATION_QUIRK_PLATFORM_DEPENDENT;
+
+    // States are always allocated after querying retro_serialize_size, so variable sizes are fine.
+    *quirks = (*quirks & supportedQuirks) | RETRO_SERIALIZATION_QUIRK_FRONT_VARIABLE_SIZE;
     return true;
 }
 
@@ -211,11 +239,20 @@ bool Environment::handle_callback_set_rumble_state(unsigned port, enum retro_rum
     LOGV("Setting rumble strength for port %i to %i", port, strength);
     if (port < 0 || port > 3) return false;
 
-    if (effect == RETRO_RUMBLE_STRONG) {
-        rumbleStates[port].strengthStrong = strength;
-    } else if (effect == RETRO_RUMBLE_WEAK) {
-        rumbleStates[port].strengthWeak = strength;
-    }
+    if (effect != RETRO_RUMBLE_STRONG && effect != RETRO_RUMBLE_WEAK) return false;
+
+    auto& state = rumbleStates[port];
+    uint16_t& current = effect == RETRO_RUMBLE_STRONG ? state.strengthStrong : state.strengthWeak;
+
+    // Many cores set the rumble state on every frame, only changes are worth an event.
+    if (current == strength) return true;
+    current = strength;
+
+    libretrodroid::EnvironmentEvent event;
+    event.type = libretrodroid::EnvironmentEvent::Type::RUMBLE;
+    event.port = port;
+    event.rumbleState = rumbleStates[port];
+    pushEvent(std::move(event));
 
     return true;
 }
@@ -289,7 +326,11 @@ bool Environment::handle_callback_environment(unsigned cmd, void *data) {
             LOGD("Called RETRO_ENVIRONMENT_SET_ROTATION");
             unsigned screenRotationIndex = (*static_cast<unsigned*>(data));
             screenRotation = screenRotationIndex * (float) (-M_PI / 2.0);
-            screenRotationUpdated = true;
+
+            libretrodroid::EnvironmentEvent event;
+            event.type = libretrodroid::EnvironmentEvent::Type::ROTATION;
+            event.rotation = screenRotation;
+            pushEvent(std::move(event));
             return true;
         }
 
@@ -301,18 +342,29 @@ bool Environment::handle_callback_environment(unsigned cmd, void *data) {
 
         case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
             LOGD("Called RETRO_ENVIRONMENT_GET_PERF_INTERFACE");
-            return false;
+            libretrodroid::PerfCounters::fillCallback(static_cast<struct retro_perf_callback*>(data));
+            return true;
 
-            // TODO... RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO can also change frame-rate
         case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
-        case RETRO_ENVIRONMENT_SET_GEOMETRY: {
-            struct retro_game_geometry *geometry = static_cast<struct retro_game_geometry *>(data);
-            gameGeometryHeight = geometry->base_height;
-            gameGeometryWidth = geometry->base_width;
-            gameGeometryAspectRatio = geometry->aspect_ratio;
-            gameGeometryUpdated = true;
+            LOGD("Called RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO");
+            return environment_handle_set_system_av_info(static_cast<const struct retro_system_av_info*>(data));
+
+        case RETRO_ENVIRONMENT_SET_GEOMETRY:
+            LOGD("Called RETRO_ENVIRONMENT_SET_GEOMETRY");
+            return environment_handle_set_geometry(static_cast<const struct retro_game_geometry*>(data));
+
+        case RETRO_ENVIRONMENT_GET_MESSAGE_INTERFACE_VERSION:
+            LOGD("Called RETRO_ENVIRONMENT_GET_MESSAGE_INTERFACE_VERSION");
+            *((unsigned*) data) = 1;
             return true;
-        }
+
+        case RETRO_ENVIRONMENT_SET_MESSAGE:
+            LOGD("Called RETRO_ENVIRONMENT_SET_MESSAGE");
+            return environment_handle_set_message(static_cast<const struct retro_message*>(data));
+
+        case RETRO_ENVIRONMENT_SET_MESSAGE_EXT:
+            LOGD("Called RETRO_ENVIRONMENT_SET_MESSAGE_EXT");
+            return environment_handle_set_message_ext(static_cast<const struct retro_message_ext*>(data));
 
         case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
             LOGD("Called RETRO_ENVIRONMENT_SET_CONTROLLER_INFO");
@@ -320,7 +372,14 @@ bool Environment::handle_callback_environment(unsigned cmd, void *data) {
 
         case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
             LOGD("Called RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE");
-            return false;
+            if (data != nullptr) {
+                *((int*) data) = audioVideoEnable;
+            }
+            return true;
+
+        case RETRO_ENVIRONMENT_SET_SERIALIZATION_QUIRKS:
+            LOGD("Called RETRO_ENVIRONMENT_SET_SERIALIZATION_QUIRKS");
+            return environment_handle_set_serialization_quirks(static_cast<uint64_t*>(data));
 
         case RETRO_ENVIRONMENT_GET_LANGUAGE:
             LOGD("Called RETRO_ENVIRONMENT_GET_LANGUAGE");
@@ -335,6 +394,39 @@ bool Environment::handle_callback_environment(unsigned cmd, void *data) {
             LOGD("Called RETRO_ENVIRONMENT_GET_MICROPHONE_INTERFACE");
             return environment_handle_get_microphone_interface(static_cast<struct retro_microphone_interface*>(data));
 
+        case RETRO_ENVIRONMENT_GET_THROTTLE_STATE:
+            LOGD("Called RETRO_ENVIRONMENT_GET_THROTTLE_STATE");
+            *((struct retro_throttle_state*) data) = throttleState;
+            return true;
+
+        case RETRO_ENVIRONMENT_GET_FASTFORWARDING:
+            LOGD("Called RETRO_ENVIRONMENT_GET_FASTFORWARDING");
+            *((bool*) data) = throttleState.mode == RETRO_THROTTLE_FAST_FORWARD;
+            return true;
+
+        case RETRO_ENVIRONMENT_SET_FASTFORWARDING_OVERRIDE:
+            LOGD("Called RETRO_ENVIRONMENT_SET_FASTFORWARDING_OVERRIDE");
+            return environment_handle_set_fastforwarding_override(
+                static_cast<const struct retro_fastforwarding_override*>(data)
+            );
+
+        case RETRO_ENVIRONMENT_GET_TARGET_REFRESH_RATE:
+            LOGD("Called RETRO_ENVIRONMENT_GET_TARGET_REFRESH_RATE");
+            *((float*) data) = targetRefreshRate;
+            return true;
+
+        // A null pointer unregisters the callback.
+        case RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK: {
+            LOGD("Called RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK");
+            auto callback = static_cast<const struct retro_audio_buffer_status_callback*>(data);
+            audioBufferStatusCallback = callback != nullptr ? callback->callback : nullptr;
+            return true;
+        }
+
+        case RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY:
+            LOGD("Called RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY");
+            return environment_handle_set_minimum_audio_latency(static_cast<const unsigned*>(data));
+
         default:
             LOGD("callback environment has been called: %u", cmd);
             return false;
@@ -403,14 +495,6 @@ float Environment::getScreenRotation() const {
     return screenRotation;
 }
 
-bool Environment::isGameGeometryUpdated() const {
-    return gameGeometryUpdated;
-}
-
-void Environment::clearGameGeometryUpdated() {
-    gameGeometryUpdated = false;
-}
-
 unsigned int Environment::getGameGeometryWidth() const {
     return gameGeometryWidth;
 }
@@ -461,16 +545,150 @@ float Environment::retrieveGameSpecificAspectRatio() {
     return -1.0f;
 }
 
-bool Environment::isScreenRotationUpdated() const {
-    return screenRotationUpdated;
+bool Environment::environment_handle_set_geometry(const struct retro_game_geometry* geometry) {
+    if (geometry == nullptr) return false;
+
+    gameGeometryWidth = geometry->base_width;
+    gameGeometryHeight = geometry->base_height;
+    gameGeometryAspectRatio = geometry->aspect_ratio;
+
+    libretrodroid::EnvironmentEvent event;
+    event.type = libretrodroid::EnvironmentEvent::Type::GEOMETRY;
+    event.geometry = { gameGeometryWidth, gameGeometryHeight, gameGeometryAspectRatio };
+    pushEvent(std::move(event));
+    return true;
 }
 
-void Environment::clearScreenRotationUpdated() {
-    screenRotationUpdated = false;
+bool Environment::environment_handle_set_system_av_info(const struct retro_system_av_info* avInfo) {
+    if (avInfo == nullptr) return false;
+
+    gameGeometryWidth = avInfo->geometry.base_width;
+    gameGeometryHeight = avInfo->geometry.base_height;
+    gameGeometryAspectRatio = avInfo->geometry.aspect_ratio;
+    gameTiming = { avInfo->timing.fps, avInfo->timing.sample_rate };
+
+    libretrodroid::EnvironmentEvent event;
+    event.type = libretrodroid::EnvironmentEvent::Type::AV_INFO;
+    event.geometry = { gameGeometryWidth, gameGeometryHeight, gameGeometryAspectRatio };
+    event.timing = gameTiming;
+    pushEvent(std::move(event));
+    return true;
 }
 
-std::array<libretrodroid::RumbleState, 4>& Environment::getLastRumbleStates() {
-    return rumbleStates;
+bool Environment::environment_handle_set_message(const struct retro_message* message) {
+    if (message == nullptr || message->msg == nullptr) return false;
+
+    LOGI("Core message: %s", message->msg);
+
+    // Legacy messages are timed in frames, we assume the nominal 60 fps to convert them.
+    libretrodroid::EnvironmentEvent event;
+    event.type = libretrodroid::EnvironmentEvent::Type::MESSAGE;
+    event.message.text = message->msg;
+    event.message.durationMs = message->frames * 1000 / 60;
+    pushEvent(std::move(event));
+    return true;
+}
+
+bool Environment::environment_handle_set_message_ext(const struct retro_message_ext* message) {
+    if (message == nullptr || message->msg == nullptr) return false;
+
+    LOGI("Core message: %s", message->msg);
+
+    if (message->target == RETRO_MESSAGE_TARGET_LOG) {
+        return true;
+    }
+
+    libretrodroid::EnvironmentEvent event;
+    event.type = libretrodroid::EnvironmentEvent::Type::MESSAGE;
+    event.message.text = message->msg;
+    event.message.durationMs = message->duration;
+    event.message.priority = message->priority;
+    pushEvent(std::move(event));
+    return true;
+}
+
+// Cores call this with a null pointer to check whether the override is supported.
+bool Environment::environment_handle_set_fastforwarding_override(const struct retro_fastforwarding_override* value) {
+    if (value == nullptr) return true;
+
+    LOGI(
+        "Core requested fast forward override (ratio: %f) (enabled: %d) (inhibit toggle: %d)",
+        value->ratio,
+        value->fastforward,
+        value->inhibit_toggle
+    );
+
+    fastForwardingOverride = *value;
+    return true;
+}
+
+// A zero latency restores the default buffer size.
+bool Environment::environment_handle_set_minimum_audio_latency(const unsigned* latency) {
+    if (latency == nullptr) return false;
+
+    if (*latency == minimumAudioLatency) return true;
+    minimumAudioLatency = *latency;
+
+    libretrodroid::EnvironmentEvent event;
+    event.type = libretrodroid::EnvironmentEvent::Type::AUDIO_LATENCY;
+    event.minimumAudioLatencyMs = minimumAudioLatency;
+    pushEvent(std::move(event));
+    return true;
+}
+
+void Environment::pushEvent(libretrodroid::EnvironmentEvent&& event) {
+    if (!events.push(std::move(event))) {
+        LOGW("Environment event queue is full, the state will be resynchronized");
+        eventsOverflowed.store(true, std::memory_order_release);
+    }
+}
+
+std::vector<libretrodroid::EnvironmentEvent> Environment::buildStateEvents() const {
+    std::vector<libretrodroid::EnvironmentEvent> result;
+
+    libretrodroid::EnvironmentEvent geometryEvent;
+    geometryEvent.type = gameTiming.fps > 0
+        ? libretrodroid::EnvironmentEvent::Type::AV_INFO
+        : libretrodroid::EnvironmentEvent::Type::GEOMETRY;
+    geometryEvent.geometry = { gameGeometryWidth, gameGeometryHeight, gameGeometryAspectRatio };
+    geometryEvent.timing = gameTiming;
+    result.push_back(geometryEvent);
+
+    libretrodroid::EnvironmentEvent rotationEvent;
+    rotationEvent.type = libretrodroid::EnvironmentEvent::Type::ROTATION;
+    rotationEvent.rotation = screenRotation;
+    result.push_back(rotationEvent);
+
+    for (unsigned port = 0; port < rumbleStates.size(); ++port) {
+        libretrodroid::EnvironmentEvent rumbleEvent;
+        rumbleEvent.type = libretrodroid::EnvironmentEvent::Type::RUMBLE;
+        rumbleEvent.port = port;
+        rumbleEvent.rumbleState = rumbleStates[port];
+        result.push_back(rumbleEvent);
+    }
+
+    libretrodroid::EnvironmentEvent audioLatencyEvent;
+    audioLatencyEvent.type = libretrodroid::EnvironmentEvent::Type::AUDIO_LATENCY;
+    audioLatencyEvent.minimumAudioLatencyMs = minimumAudioLatency;
+    result.push_back(audioLatencyEvent);
+
+    return result;
+}
+
+void Environment::drainEvents(const std::function<void(libretrodroid::EnvironmentEvent&)>& handler) {
+    bool overflowed = eventsOverflowed.exchange(false, std::memory_order_acq_rel);
+
+    libretrodroid::EnvironmentEvent event;
+    while (events.pop(event)) {
+        handler(event);
+    }
+
+    if (!overflowed) return;
+
+    // Some events were dropped, the latest values supersede them. Messages are lost though.
+    for (auto& stateEvent : buildStateEvents()) {
+        handler(stateEvent);
+    }
 }
 
 void Environment::setEnableVirtualFileSystem(bool value) {
@@ -480,3 +698,39 @@ void Environment::setEnableVirtualFileSystem(bool value) {
 void Environment::setEnableMicrophone(bool value) {
     this->enableMicrophone = value;
 }
+
+void Environment::setMicrophoneInterface(struct retro_microphone_interface* interface) {
+    this->microphoneInterface = interface;
+}
+
+int Environment::getAudioVideoEnable() const {
+    return audioVideoEnable;
+}
+
+void Environment::setAudioVideoEnable(int flags) {
+    audioVideoEnable = flags;
+}
+
+void Environment::setThrottleState(unsigned mode, float rate) {
+    throttleState = { mode, rate };
+}
+
+void Environment::setTargetRefreshRate(float refreshRate) {
+    targetRefreshRate = refreshRate;
+}
+
+const struct retro_fastforwarding_override& Environment::getFastForwardingOverride() const {
+    return fastForwardingOverride;
+}
+
+unsigned Environment::getMinimumAudioLatency() const {
+    return minimumAudioLatency;
+}
+
+retro_audio_buffer_status_callback_t Environment::getAudioBufferStatusCallback() const {
+    return audioBufferStatusCallback;
+}
+
+uint64_t Environment::getSerializationQuirks() const {
+    return serializationQuirks;
+}
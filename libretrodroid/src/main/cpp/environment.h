@@ -27,18 +27,36 @@
 #include <EGL/egl.h>
 #include <unordered_map>
 #include <array>
+#include <atomic>
+#include <functional>
 
 #include "../../libretro-common/include/libretro.h"
 #include "log.h"
 #include "rumblestate.h"
+#include "environmentevent.h"
+#include "utils/spscqueue.h"
+#include "utils/threadbinding.h"
 
 class Environment {
 public:
+    // Bits reported through RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE.
+    static constexpr int AUDIO_VIDEO_ENABLE_VIDEO = 1 << 0;
+    static constexpr int AUDIO_VIDEO_ENABLE_AUDIO = 1 << 1;
+    static constexpr int AUDIO_VIDEO_ENABLE_FAST_SAVESTATES = 1 << 2;
+    static constexpr int AUDIO_VIDEO_ENABLE_HARD_DISABLE_AUDIO = 1 << 3;
+
+    using Binding = libretrodroid::ThreadBinding<Environment>;
+
+    // Returns the environment bound to the calling thread, or the process wide one.
     static Environment& getInstance()
     {
+        Environment* bound = Binding::get();
+        if (bound) return *bound;
+
         static Environment instance;
         return instance;
     }
+    Environment() {}
     Environment(Environment const&) = delete;
     void operator=(Environment const&) = delete;
 
@@ -54,11 +72,8 @@ public:
 
     void setEnableVirtualFileSystem(bool value);
     void setEnableMicrophone(bool value);
+    void setMicrophoneInterface(struct retro_microphone_interface* interface);
 
-private:
-    Environment() {}
-
-public:
     void initialize(
         const std::string &requiredSystemDirectory,
         const std::string &requiredSavesDirectory,
@@ -93,16 +108,32 @@ public:
     bool isBottomLeftOrigin() const;
 
     float getScreenRotation() const;
-    bool isScreenRotationUpdated() const;
-    void clearScreenRotationUpdated();
 
     unsigned int getGameGeometryWidth() const;
     unsigned int getGameGeometryHeight() const;
     float getGameGeometryAspectRatio() const;
-    bool isGameGeometryUpdated() const;
-    void clearGameGeometryUpdated();
 
-    std::array<libretrodroid::RumbleState, 4> & getLastRumbleStates();
+    // Delivers the events queued by the core since the last call. Must always be called from the
+    // same thread, while the core only pushes from the thread running it.
+    void drainEvents(const std::function<void(libretrodroid::EnvironmentEvent&)>& handler);
+
+    int getAudioVideoEnable() const;
+    void setAudioVideoEnable(int flags);
+
+    // Reported through RETRO_ENVIRONMENT_GET_THROTTLE_STATE and GET_FASTFORWARDING. Must be updated
+    // from the thread running the core.
+    void setThrottleState(unsigned mode, float rate);
+    void setTargetRefreshRate(float refreshRate);
+
+    // Requested by the core through RETRO_ENVIRONMENT_SET_FASTFORWARDING_OVERRIDE.
+    const struct retro_fastforwarding_override& getFastForwardingOverride() const;
+
+    unsigned getMinimumAudioLatency() const;
+
+    // Set by cores which skip frames on their own when the audio buffer runs low. Null otherwise.
+    retro_audio_buffer_status_callback_t getAudioBufferStatusCallback() const;
+
+    uint64_t getSerializationQuirks() const;
 
     const std::vector<struct Variable> getVariables() const;
 
@@ -115,6 +146,16 @@ private:
     bool environment_handle_set_hw_render(struct retro_hw_render_callback* hw_render_callback);
     bool environment_handle_get_vfs_interface(struct retro_vfs_interface_info* vfs_interface_info);
     bool environment_handle_get_microphone_interface(struct retro_microphone_interface* microphone_interface);
+    bool environment_handle_set_serialization_quirks(uint64_t* quirks);
+    bool environment_handle_set_geometry(const struct retro_game_geometry* geometry);
+    bool environment_handle_set_system_av_info(const struct retro_system_av_info* avInfo);
+    bool environment_handle_set_message(const struct retro_message* message);
+    bool environment_handle_set_message_ext(const struct retro_message_ext* message);
+    bool environment_handle_set_fastforwarding_override(const struct retro_fastforwarding_override* value);
+    bool environment_handle_set_minimum_audio_latency(const unsigned* latency);
+
+    void pushEvent(libretrodroid::EnvironmentEvent&& event);
+    std::vector<libretrodroid::EnvironmentEvent> buildStateEvents() const;
 
 private:
     retro_hw_context_reset_t hw_context_reset = nullptr;
@@ -127,6 +168,7 @@ private:
     unsigned language = RETRO_LANGUAGE_ENGLISH;
     bool useVirtualFileSystem = false;
     bool enableMicrophone = false;
+    struct retro_microphone_interface* microphoneInterface = nullptr;
 
     int pixelFormat = RETRO_PIXEL_FORMAT_RGB565;
     bool useHWAcceleration = false;
@@ -135,15 +177,27 @@ private:
     bool bottomLeftOrigin = false;
 
     float screenRotation = 0;
-    bool screenRotationUpdated = false;
 
-    bool gameGeometryUpdated = false;
     unsigned gameGeometryWidth = 0;
     unsigned gameGeometryHeight = 0;
     float gameGeometryAspectRatio = -1.0f;
+    libretrodroid::EnvironmentEvent::Timing gameTiming;
 
     std::array<libretrodroid::RumbleState, 4> rumbleStates;
 
+    // When the queue overflows the consumer receives the latest state instead of the lost events.
+    libretrodroid::SPSCQueue<libretrodroid::EnvironmentEvent, 64> events;
+    std::atomic<bool> eventsOverflowed { false };
+
+    int audioVideoEnable = AUDIO_VIDEO_ENABLE_VIDEO | AUDIO_VIDEO_ENABLE_AUDIO;
+
+    struct retro_throttle_state throttleState { RETRO_THROTTLE_NONE, 0.0f };
+    float targetRefreshRate = 60.0f;
+    struct retro_fastforwarding_override fastForwardingOverride { 0.0f, false, false, false };
+    unsigned minimumAudioLatency = 0;
+    retro_audio_buffer_status_callback_t audioBufferStatusCallback = nullptr;
+    uint64_t serializationQuirks = 0;
+
     std::unordered_map<std::string, struct Variable> variables;
     bool dirtyVariables = false;
 
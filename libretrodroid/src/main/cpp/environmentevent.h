@@ -0,0 +1,80 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_ENVIRONMENTEVENT_H
+#define LIBRETRODROID_ENVIRONMENTEVENT_H
+
+#include <string>
+
+#include "rumblestate.h"
+
+namespace libretrodroid {
+
+// Changes requested by the core through the environment callback, in the order they were made.
+struct EnvironmentEvent {
+    enum class Type {
+        GEOMETRY,
+        ROTATION,
+        AV_INFO,
+        RUMBLE,
+        MESSAGE,
+        AUDIO_LATENCY,
+    };
+
+    struct Geometry {
+        unsigned width = 0;
+        unsigned height = 0;
+        float aspectRatio = -1.0f;
+    };
+
+    struct Timing {
+        double fps = 0.0;
+        double sampleRate = 0.0;
+    };
+
+    struct Message {
+        std::string text;
+        unsigned durationMs = 0;
+        unsigned priority = 0;
+    };
+
+    Type type = Type::GEOMETRY;
+
+    // GEOMETRY and AV_INFO
+    Geometry geometry;
+
+    // AV_INFO
+    Timing timing;
+
+    // ROTATION
+    float rotation = 0.0f;
+
+    // RUMBLE
+    unsigned port = 0;
+    RumbleState rumbleState;
+
+    // MESSAGE
+    Message message;
+
+    // AUDIO_LATENCY
+    unsigned minimumAudioLatencyMs = 0;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_ENVIRONMENTEVENT_H
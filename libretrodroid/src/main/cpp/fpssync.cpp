@@ -16,49 +16,205 @@
  */
 
 #include <cmath>
+#include <algorithm>
 #include "fpssync.h"
 #include "log.h"
+#include "frametimings.h"
 
 namespace libretrodroid {
 
+// Sleeping is only accurate to a few milliseconds, so we wake up a bit earlier and spin until the
+// deadline. The spin window adapts to the oversleep we observe on the device.
+static constexpr std::chrono::nanoseconds MIN_SPIN_THRESHOLD = std::chrono::microseconds(100);
+static constexpr std::chrono::nanoseconds MAX_SPIN_THRESHOLD = std::chrono::microseconds(500);
+static constexpr std::chrono::nanoseconds DEFAULT_SPIN_THRESHOLD = std::chrono::microseconds(300);
+static constexpr double LATE_FRAME_THRESHOLD_US = 1000.0;
+
+TimePoint FPSSync::SteadyClock::now() {
+    return std::chrono::steady_clock::now();
+}
+
+void FPSSync::SteadyClock::sleepUntil(TimePoint timePoint) {
+    std::this_thread::sleep_until(timePoint);
+}
+
+void FPSSync::SteadyClock::spinUntil(TimePoint timePoint) {
+    while (now() < timePoint) {
+        std::this_thread::yield();
+    }
+}
+
 unsigned FPSSync::advanceFrames() {
+    applyRequestedRefreshRate();
+
+    lateness = 0.0;
     if (useVSync) return 1;
 
+    if (usePrecisePacing) return advanceFramesPrecise();
+
     if (lastFrame == MIN_TIME) {
         start();
     }
 
-    auto now = std::chrono::steady_clock::now();
-    auto frames = std::max((now - lastFrame) / sampleInterval, (long long) 1);
+    auto now = clock->now();
+    lateness = std::max(std::chrono::duration<double>(now - lastFrame) / sampleInterval, 0.0);
+    auto frames = std::max<long long>((now - lastFrame) / sampleInterval, 1);
     lastFrame = lastFrame + sampleInterval * frames;
 
     return frames;
 }
 
-FPSSync::FPSSync(double contentRefreshRate, double screenRefreshRate) {
-    this->contentRefreshRate = contentRefreshRate;
+unsigned FPSSync::advanceFramesPrecise() {
+    if (startTime == MIN_TIME) {
+        start();
+    }
+
+    auto elapsed = std::chrono::duration<double>(clock->now() - getFrameDeadline(frameIndex));
+    lateness = std::max(elapsed.count() * contentRefreshRate, 0.0);
+    auto frames = std::max((int64_t) std::floor(elapsed.count() * contentRefreshRate), (int64_t) 1);
+    frameIndex += frames;
+
+    return (unsigned) frames;
+}
+
+FPSSync::FPSSync(
+    double contentRefreshRate,
+    double screenRefreshRate,
+    bool allowVSync,
+    bool precisePacing,
+    std::unique_ptr<Clock> clock
+) : clock(std::move(clock)) {
     this->screenRefreshRate = screenRefreshRate;
-    this->useVSync = std::abs(contentRefreshRate - screenRefreshRate) < FPS_TOLERANCE;
-    this->sampleInterval = std::chrono::microseconds((long) ((1000000L / contentRefreshRate)));
+    this->allowVSync = allowVSync;
+    this->usePrecisePacing = precisePacing;
+    this->spinThreshold = DEFAULT_SPIN_THRESHOLD;
+    configure(contentRefreshRate);
     reset();
 }
 
+void FPSSync::configure(double refreshRate) {
+    this->contentRefreshRate = refreshRate;
+    this->useVSync = shouldUseVSync(refreshRate);
+    this->sampleInterval = std::chrono::microseconds((long) ((1000000L / refreshRate)));
+}
+
+bool FPSSync::shouldUseVSync(double refreshRate) const {
+    return allowVSync && std::abs(refreshRate - screenRefreshRate) < FPS_TOLERANCE;
+}
+
+void FPSSync::setContentRefreshRate(double refreshRate) {
+    if (refreshRate <= 0.0) return;
+    requestedRefreshRate.store(refreshRate);
+}
+
+void FPSSync::applyRequestedRefreshRate() {
+    double refreshRate = requestedRefreshRate.exchange(0.0);
+    if (refreshRate <= 0.0 || refreshRate == contentRefreshRate) return;
+
+    LOGI("Content refresh rate changed from %f to %f", contentRefreshRate, refreshRate);
+
+    // Deadlines are computed from the start time, so we move it to the next deadline and count
+    // frames again from there with the new interval.
+    bool started = startTime != MIN_TIME;
+    TimePoint nextDeadline = started ? getFrameDeadline(frameIndex) : MIN_TIME;
+
+    configure(refreshRate);
+
+    if (started) {
+        startTime = nextDeadline;
+        frameIndex = 0;
+    }
+}
+
 void FPSSync::start() {
-    LOGI("Starting game with fps %f on a screen with refresh rate %f. Using vsync: %d", contentRefreshRate, screenRefreshRate, useVSync);
-    lastFrame = std::chrono::steady_clock::now();
+    LOGI("Starting game with fps %f on a screen with refresh rate %f. Using vsync: %d. Precise pacing: %d", contentRefreshRate, screenRefreshRate, useVSync, usePrecisePacing);
+    lastFrame = clock->now();
+    startTime = lastFrame;
+    frameIndex = 0;
+}
+
+double FPSSync::getLateness() const {
+    return lateness;
+}
+
+bool FPSSync::isUsingVSync() const {
+    return useVSync;
 }
 
 void FPSSync::reset() {
+    lateness = 0.0;
     lastFrame = MIN_TIME;
+    startTime = MIN_TIME;
+    frameIndex = 0;
 }
 
 double FPSSync::getTimeStretchFactor() {
     return useVSync ? contentRefreshRate / screenRefreshRate : 1.0;
 }
 
+double FPSSync::getTimeStretchFactor(double refreshRate) const {
+    return shouldUseVSync(refreshRate) ? refreshRate / screenRefreshRate : 1.0;
+}
+
 void FPSSync::wait() {
     if (useVSync) return;
-    std::this_thread::sleep_until(lastFrame);
+
+    ScopedTiming timing(FrameTimings::PHASE_FPS_WAIT);
+
+    if (usePrecisePacing) {
+        waitPrecise();
+        return;
+    }
+
+    clock->sleepUntil(lastFrame);
+    recordFrameError(lastFrame, clock->now());
+}
+
+void FPSSync::waitPrecise() {
+    TimePoint deadline = getFrameDeadline(frameIndex);
+    TimePoint sleepTarget = deadline - spinThreshold;
+
+    if (clock->now() < sleepTarget) {
+        clock->sleepUntil(sleepTarget);
+
+        auto oversleep = clock->now() - sleepTarget;
+        if (oversleep > spinThreshold) {
+            spinThreshold = std::min<std::chrono::nanoseconds>(oversleep, MAX_SPIN_THRESHOLD);
+        } else {
+            spinThreshold = std::max<std::chrono::nanoseconds>(spinThreshold - (spinThreshold - oversleep) / 16, MIN_SPIN_THRESHOLD);
+        }
+    }
+
+    clock->spinUntil(deadline);
+    recordFrameError(deadline, clock->now());
+}
+
+TimePoint FPSSync::getFrameDeadline(int64_t frame) const {
+    auto offset = std::llround((double) frame * 1000000000.0 / contentRefreshRate);
+    return startTime + std::chrono::nanoseconds(offset);
+}
+
+void FPSSync::recordFrameError(TimePoint deadline, TimePoint end) {
+    double error = std::chrono::duration<double, std::micro>(end - deadline).count();
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.frames++;
+    stats.lateFrames += error > LATE_FRAME_THRESHOLD_US ? 1 : 0;
+    stats.meanError += (error - stats.meanError) / stats.frames;
+    stats.maxError = std::max(stats.maxError, std::abs(error));
+    squaredErrorSum += error * error;
+    stats.rmsError = std::sqrt(squaredErrorSum / stats.frames);
+}
+
+FPSSync::Stats FPSSync::getStats() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+void FPSSync::resetStats() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats = Stats {};
+    squaredErrorSum = 0.0;
 }
 
 } //namespace libretrodroid
@@ -20,6 +20,10 @@
 
 #include <chrono>
 #include <thread>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <atomic>
 
 namespace libretrodroid {
 
@@ -28,18 +32,78 @@ typedef std::chrono::duration<long, std::micro> Duration;
 
 class FPSSync {
 public:
-    FPSSync(double contentRefreshRate, double screenRefreshRate);
+    // Time source used for pacing. It can be replaced to drive FPSSync deterministically.
+    class Clock {
+    public:
+        virtual ~Clock() = default;
+        virtual TimePoint now() = 0;
+        virtual void sleepUntil(TimePoint timePoint) = 0;
+
+        // Busy waits until the given time point, used for the last stretch before a deadline.
+        virtual void spinUntil(TimePoint timePoint) = 0;
+    };
+
+    class SteadyClock : public Clock {
+    public:
+        TimePoint now() override;
+        void sleepUntil(TimePoint timePoint) override;
+        void spinUntil(TimePoint timePoint) override;
+    };
+
+    // Difference between the actual end of wait() and the frame deadline, in microseconds.
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t lateFrames = 0;
+        double meanError = 0.0;
+        double rmsError = 0.0;
+        double maxError = 0.0;
+    };
+
+    FPSSync(
+        double contentRefreshRate,
+        double screenRefreshRate,
+        bool allowVSync,
+        bool precisePacing = false,
+        std::unique_ptr<Clock> clock = std::make_unique<SteadyClock>()
+    );
     ~FPSSync() { }
 
     void reset();
     unsigned advanceFrames();
     void wait();
+
+    // How late the last advanceFrames() call was with respect to the frame deadline, in frames.
+    // Always zero when pacing is left to vsync.
+    double getLateness() const;
+
+    bool isUsingVSync() const;
     double getTimeStretchFactor();
+
+    // Stretch factor which will be used once the given content refresh rate is applied.
+    double getTimeStretchFactor(double refreshRate) const;
+
+    // Can be called from any thread, the new rate is applied by the next advanceFrames() without
+    // moving the deadlines of the frames which have already been scheduled.
+    void setContentRefreshRate(double refreshRate);
+
+    Stats getStats();
+    void resetStats();
+
 private:
+    unsigned advanceFramesPrecise();
+    void configure(double refreshRate);
+    void applyRequestedRefreshRate();
+    bool shouldUseVSync(double refreshRate) const;
+    void waitPrecise();
+    TimePoint getFrameDeadline(int64_t frame) const;
+    void recordFrameError(TimePoint deadline, TimePoint end);
 
+private:
     double screenRefreshRate;
     double contentRefreshRate;
+    bool allowVSync;
     bool useVSync;
+    bool usePrecisePacing;
     const double FPS_TOLERANCE = 5;
 
     const TimePoint MIN_TIME = TimePoint::min();
@@ -47,6 +111,21 @@ private:
 
     TimePoint lastFrame = MIN_TIME;
     Duration sampleInterval;
+
+    // Precise pacing computes every deadline from the start time, so rounding errors never accumulate.
+    TimePoint startTime = MIN_TIME;
+    int64_t frameIndex = 0;
+    std::chrono::nanoseconds spinThreshold;
+
+    std::unique_ptr<Clock> clock;
+
+    double lateness = 0.0;
+
+    std::atomic<double> requestedRefreshRate { 0.0 };
+
+    std::mutex statsMutex;
+    Stats stats;
+    double squaredErrorSum = 0.0;
 };
 
 }
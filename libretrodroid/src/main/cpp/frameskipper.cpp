@@ -0,0 +1,54 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "frameskipper.h"
+
+namespace libretrodroid {
+
+bool FrameSkipper::shouldSkipFrame(double lateness, double audioFillLevel) {
+    audioPrimed = audioPrimed || audioFillLevel >= EXIT_AUDIO_FILL_LEVEL;
+    if (!audioPrimed) {
+        audioFillLevel = 1.0;
+    }
+
+    if (skipping) {
+        skipping = lateness > EXIT_LATENESS || audioFillLevel < EXIT_AUDIO_FILL_LEVEL;
+    } else {
+        skipping = lateness > ENTER_LATENESS || isAudioUnderrunLikely(audioFillLevel);
+    }
+
+    if (!skipping || consecutiveSkips >= MAX_CONSECUTIVE_SKIPS) {
+        consecutiveSkips = 0;
+        return false;
+    }
+
+    consecutiveSkips++;
+    return true;
+}
+
+bool FrameSkipper::isAudioUnderrunLikely(double audioFillLevel) {
+    return audioFillLevel < ENTER_AUDIO_FILL_LEVEL;
+}
+
+void FrameSkipper::reset() {
+    skipping = false;
+    audioPrimed = false;
+    consecutiveSkips = 0;
+}
+
+} //namespace libretrodroid
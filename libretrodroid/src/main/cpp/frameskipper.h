@@ -0,0 +1,56 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_FRAMESKIPPER_H
+#define LIBRETRODROID_FRAMESKIPPER_H
+
+namespace libretrodroid {
+
+// Decides when a frame should be emulated without producing video, so that a device which cannot
+// keep up drops frames instead of starving the audio stream. Skipping starts when the frame is late
+// or the audio buffer is running low and stops once both have recovered, so that it does not toggle
+// on every frame. A frame is always shown after MAX_CONSECUTIVE_SKIPS skipped ones. The audio
+// buffer starts empty, so its fill level is ignored until it has been filled up once.
+class FrameSkipper {
+public:
+    // Lateness is measured in frames, the audio fill level ranges from 0 to 1.
+    bool shouldSkipFrame(double lateness, double audioFillLevel);
+
+    // Must be called when the audio stream is restarted, for example after a pause.
+    void reset();
+
+    // True when the buffer is low enough that a slow frame could make the stream run out of samples.
+    // Also reported to the core, so that its own frame skipping agrees with ours.
+    static bool isAudioUnderrunLikely(double audioFillLevel);
+
+private:
+    static constexpr double ENTER_LATENESS = 0.5;
+    static constexpr double EXIT_LATENESS = 0.2;
+    // The audio controller keeps the buffer half full, a quarter leaves about one slow frame of margin.
+    static constexpr double ENTER_AUDIO_FILL_LEVEL = 0.25;
+    static constexpr double EXIT_AUDIO_FILL_LEVEL = 0.4;
+    static constexpr unsigned MAX_CONSECUTIVE_SKIPS = 3;
+
+    bool skipping = false;
+    bool audioPrimed = false;
+    unsigned consecutiveSkips = 0;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_FRAMESKIPPER_H
@@ -0,0 +1,81 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "frametimings.h"
+
+#include <algorithm>
+
+namespace libretrodroid {
+
+const char* FrameTimings::getPhaseName(Phase phase) {
+    switch (phase) {
+        case PHASE_RETRO_RUN: return "retro_run";
+        case PHASE_FRAME_UPLOAD: return "frame_upload";
+        case PHASE_IMMERSIVE_BACKGROUND: return "immersive_background";
+        case PHASE_SHADER_PASS_0: return "shader_pass_0";
+        case PHASE_SHADER_PASS_1: return "shader_pass_1";
+        case PHASE_SHADER_PASS_2: return "shader_pass_2";
+        case PHASE_SHADER_PASS_3: return "shader_pass_3";
+        case PHASE_FPS_WAIT: return "fps_wait";
+        default: return "unknown";
+    }
+}
+
+void FrameTimings::setEnabled(bool value) {
+    if (value && !isEnabled()) {
+        reset();
+    }
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+std::vector<FrameTimings::Stats> FrameTimings::getStats() {
+    std::vector<Stats> result;
+    std::vector<uint32_t> values;
+    values.reserve(RING_SIZE);
+
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        auto& ring = rings[phase];
+        uint32_t samples = std::min(ring.count.load(std::memory_order_relaxed), RING_SIZE);
+        if (samples == 0) continue;
+
+        values.clear();
+        for (uint32_t i = 0; i < samples; i++) {
+            values.push_back(ring.samples[i].load(std::memory_order_relaxed));
+        }
+        std::sort(values.begin(), values.end());
+
+        result.push_back(Stats {
+            (Phase) phase,
+            samples,
+            values.front(),
+            values[(samples - 1) * 50 / 100],
+            values[(samples - 1) * 95 / 100],
+            values.back()
+        });
+    }
+
+    return result;
+}
+
+void FrameTimings::reset() {
+    for (auto& ring : rings) {
+        ring.count.store(0, std::memory_order_relaxed);
+    }
+}
+
+} //namespace libretrodroid
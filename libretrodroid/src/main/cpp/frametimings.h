@@ -0,0 +1,129 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_FRAMETIMINGS_H
+#define LIBRETRODROID_FRAMETIMINGS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace libretrodroid {
+
+// Rolling duration samples of the phases of a frame. Every phase has a single writer, readers can
+// run on any thread. GL phases measure command submission on the CPU, not GPU execution.
+class FrameTimings {
+public:
+    enum Phase {
+        PHASE_RETRO_RUN = 0,
+        PHASE_FRAME_UPLOAD,
+        PHASE_IMMERSIVE_BACKGROUND,
+        PHASE_SHADER_PASS_0,
+        PHASE_SHADER_PASS_1,
+        PHASE_SHADER_PASS_2,
+        PHASE_SHADER_PASS_3,
+        PHASE_FPS_WAIT,
+        PHASE_COUNT
+    };
+
+    struct Stats {
+        Phase phase;
+        uint32_t samples;
+        uint32_t min;
+        uint32_t p50;
+        uint32_t p95;
+        uint32_t max;
+    };
+
+    static FrameTimings& getInstance() {
+        static FrameTimings instance;
+        return instance;
+    }
+    FrameTimings(FrameTimings const&) = delete;
+    void operator=(FrameTimings const&) = delete;
+
+    static Phase shaderPass(size_t index) {
+        return (Phase) (PHASE_SHADER_PASS_0 + std::min<size_t>(index, PHASE_SHADER_PASS_3 - PHASE_SHADER_PASS_0));
+    }
+
+    static const char* getPhaseName(Phase phase);
+
+    bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool value);
+
+    void record(Phase phase, uint32_t micros) {
+        auto& ring = rings[phase];
+        uint32_t index = ring.count.fetch_add(1, std::memory_order_relaxed);
+        ring.samples[index % RING_SIZE].store(micros, std::memory_order_relaxed);
+    }
+
+    // Durations are in microseconds. Only phases with at least one sample are returned.
+    std::vector<Stats> getStats();
+    void reset();
+
+private:
+    FrameTimings() {}
+
+    static constexpr uint32_t RING_SIZE = 256;
+
+    struct Ring {
+        std::array<std::atomic<uint32_t>, RING_SIZE> samples {};
+        std::atomic<uint32_t> count { 0 };
+    };
+
+    std::atomic<bool> enabled { false };
+    std::array<Ring, PHASE_COUNT> rings;
+};
+
+// Records the lifetime of the object as a sample of the given phase. It does not even read the
+// clock while timings are disabled.
+class ScopedTiming {
+public:
+    explicit ScopedTiming(FrameTimings::Phase phase) : phase(phase) {
+        if (FrameTimings::getInstance().isEnabled()) {
+            start = std::chrono::steady_clock::now();
+            active = true;
+        }
+    }
+
+    ~ScopedTiming() {
+        if (!active) return;
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        FrameTimings::getInstance().record(phase, (uint32_t) micros);
+    }
+
+    ScopedTiming(ScopedTiming const&) = delete;
+    void operator=(ScopedTiming const&) = delete;
+
+private:
+    FrameTimings::Phase phase;
+    std::chrono::steady_clock::time_point start;
+    bool active = false;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_FRAMETIMINGS_H
@@ -0,0 +1,246 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Drives a libretro core as fast as possible without any Android dependency and reports the
+// emulated frame rate. Nothing is rendered and audio is discarded, so the results measure the core
+// and the frontend callbacks only. Counters registered through the libretro perf interface are
+// included in the report.
+//
+// Usage: libretrodroid-benchmark <core.so> <game> [--frames N] [--warmup N]
+//                                [--system-dir DIR] [--saves-dir DIR] [--variable KEY=VALUE]...
+//                                [--movie FILE] [--sessions N]
+//
+// With --movie the run starts from the state stored in the input movie and replays its inputs, so
+// heavy scenes can be measured reproducibly. With --sessions N the benchmark runs N copies of the
+// core in parallel and reports an array with the results of each one.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <thread>
+#include <exception>
+
+#include "headlesssession.h"
+#include "log.h"
+
+namespace libretrodroid {
+
+struct BenchmarkOptions {
+    HeadlessSession::Options session;
+    unsigned frames = 3000;
+    unsigned warmupFrames = 300;
+    unsigned sessions = 1;
+};
+
+struct BenchmarkResult {
+    std::unique_ptr<HeadlessSession> session;
+    std::vector<double> frameTimes;
+    double totalSeconds = 0.0;
+};
+
+static double percentile(const std::vector<double>& sortedValues, double percentile) {
+    if (sortedValues.empty()) return 0.0;
+
+    auto rank = (size_t) std::ceil(percentile / 100.0 * sortedValues.size());
+    return sortedValues[std::clamp(rank, (size_t) 1, sortedValues.size()) - 1];
+}
+
+static void printReport(const BenchmarkOptions& options, BenchmarkResult& result) {
+    HeadlessSession& session = *result.session;
+    const std::vector<double>& frameTimes = result.frameTimes;
+    double totalSeconds = result.totalSeconds;
+
+    struct retro_system_info system_info = session.getSystemInfo();
+    struct retro_system_av_info system_av_info = session.getSystemAVInfo();
+    const HeadlessSession::Counters& counters = session.getCounters();
+    const InputMoviePlayer* moviePlayer = session.getMoviePlayer();
+
+    std::vector<double> sortedFrameTimes(frameTimes);
+    std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+
+    double meanFrameTime = totalSeconds * 1000.0 / std::max<size_t>(frameTimes.size(), 1);
+
+    printf("{\n");
+    printf("  \"core\": \"%s\",\n", system_info.library_name);
+    printf("  \"core_version\": \"%s\",\n", system_info.library_version);
+    printf("  \"content_fps\": %.4f,\n", system_av_info.timing.fps);
+    printf("  \"frames\": %zu,\n", frameTimes.size());
+    printf("  \"warmup_frames\": %u,\n", options.warmupFrames);
+    printf("  \"total_seconds\": %.6f,\n", totalSeconds);
+    printf("  \"fps\": %.2f,\n", frameTimes.size() / totalSeconds);
+    printf("  \"speed\": %.3f,\n", frameTimes.size() / totalSeconds / system_av_info.timing.fps);
+    printf("  \"frame_time_ms\": {\n");
+    printf("    \"mean\": %.4f,\n", meanFrameTime);
+    printf("    \"p50\": %.4f,\n", percentile(sortedFrameTimes, 50));
+    printf("    \"p95\": %.4f,\n", percentile(sortedFrameTimes, 95));
+    printf("    \"p99\": %.4f,\n", percentile(sortedFrameTimes, 99));
+    printf("    \"max\": %.4f\n", sortedFrameTimes.empty() ? 0.0 : sortedFrameTimes.back());
+    printf("  },\n");
+    printf("  \"video_frames\": %llu,\n", (unsigned long long) counters.videoFrames);
+    printf("  \"duplicated_frames\": %llu,\n", (unsigned long long) counters.duplicatedFrames);
+    printf("  \"audio_frames\": %llu,\n", (unsigned long long) counters.audioFrames);
+    printf("  \"input_queries\": %llu,\n", (unsigned long long) counters.inputQueries);
+    if (moviePlayer) {
+        printf("  \"movie_frames\": %llu,\n", (unsigned long long) moviePlayer->getFrames());
+        printf("  \"movie_mismatches\": %llu,\n", (unsigned long long) moviePlayer->getMismatches());
+    }
+    printf("  \"perf_counters\": %s\n", session.getPerfCounters().toJson().c_str());
+    printf("}");
+}
+
+static void runSession(const BenchmarkOptions& options, BenchmarkResult& result) {
+    result.session = std::make_unique<HeadlessSession>(options.session);
+    HeadlessSession& session = *result.session;
+
+    for (unsigned i = 0; i < options.warmupFrames; i++) {
+        session.runFrame();
+    }
+
+    session.resetCounters();
+
+    std::vector<double>& frameTimes = result.frameTimes;
+    frameTimes.reserve(options.frames);
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastFrame = start;
+    for (unsigned i = 0; i < options.frames; i++) {
+        session.runFrame();
+
+        auto now = std::chrono::steady_clock::now();
+        frameTimes.push_back(std::chrono::duration<double, std::milli>(now - lastFrame).count());
+        lastFrame = now;
+    }
+    result.totalSeconds = std::chrono::duration<double>(lastFrame - start).count();
+}
+
+// Every session runs on its own thread with a private copy of the core, so that the scaling of the
+// core across CPUs can be measured.
+static void runBenchmark(const BenchmarkOptions& options) {
+    std::vector<BenchmarkResult> results(options.sessions);
+    std::vector<std::exception_ptr> errors(options.sessions);
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < options.sessions; i++) {
+        threads.emplace_back([&options, &results, &errors, i]() {
+            try {
+                runSession(options, results[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+
+    if (options.sessions == 1) {
+        printReport(options, results[0]);
+        printf("\n");
+        return;
+    }
+
+    printf("[\n");
+    for (unsigned i = 0; i < options.sessions; i++) {
+        printReport(options, results[i]);
+        printf(i + 1 < options.sessions ? ",\n" : "\n");
+    }
+    printf("]\n");
+}
+
+static BenchmarkOptions parseOptions(int argc, char** argv) {
+    BenchmarkOptions result;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--frames" && hasValue) {
+            result.frames = (unsigned) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--warmup" && hasValue) {
+            result.warmupFrames = (unsigned) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--system-dir" && hasValue) {
+            result.session.systemDirectory = argv[++i];
+        } else if (arg == "--saves-dir" && hasValue) {
+            result.session.savesDirectory = argv[++i];
+        } else if (arg == "--sessions" && hasValue) {
+            result.sessions = (unsigned) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--movie" && hasValue) {
+            result.session.moviePath = argv[++i];
+        } else if (arg == "--variable" && hasValue) {
+            std::string variable = argv[++i];
+            auto separator = variable.find('=');
+            if (separator == std::string::npos) {
+                throw std::invalid_argument("Variables must be in the KEY=VALUE form");
+            }
+            result.session.variables.push_back(Variable {
+                variable.substr(0, separator),
+                variable.substr(separator + 1)
+            });
+        } else if (arg.rfind("--", 0) == 0) {
+            throw std::invalid_argument("Unknown option " + arg);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (result.sessions == 0) {
+        throw std::invalid_argument("At least one session is required");
+    }
+
+    if (positional.size() != 2) {
+        throw std::invalid_argument("A core and a game are required");
+    }
+
+    result.session.corePath = positional[0];
+    result.session.gamePath = positional[1];
+    return result;
+}
+
+} //namespace libretrodroid
+
+int main(int argc, char** argv) {
+    try {
+        auto options = libretrodroid::parseOptions(argc, argv);
+        libretrodroid::runBenchmark(options);
+    } catch (std::invalid_argument& exception) {
+        fprintf(stderr, "%s\n", exception.what());
+        fprintf(
+            stderr,
+            "Usage: %s <core.so> <game> [--frames N] [--warmup N] [--system-dir DIR] "
+            "[--saves-dir DIR] [--variable KEY=VALUE]... [--movie FILE] [--sessions N]\n",
+            argv[0]
+        );
+        return 2;
+    } catch (std::exception& exception) {
+        fprintf(stderr, "Benchmark failed: %s\n", exception.what());
+        return 1;
+    }
+    return 0;
+}
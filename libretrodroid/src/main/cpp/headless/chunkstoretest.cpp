@@ -0,0 +1,230 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Runs ChunkStore on a temporary directory. The size of the packs on disk tells whether similar
+// states share their chunks and whether garbage collection frees them.
+
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "chunkstore.h"
+
+namespace libretrodroid {
+
+static int failures = 0;
+
+static void check(bool condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", message);
+        failures++;
+    }
+}
+
+static constexpr size_t STATE_SIZE = 1024 * 1024;
+
+// Random content does not compress, so pack sizes match the amount of stored data.
+static std::vector<int8_t> makeState(unsigned seed) {
+    std::mt19937 random(seed);
+    std::vector<int8_t> result(STATE_SIZE);
+    for (auto& value : result) {
+        value = (int8_t) random();
+    }
+    return result;
+}
+
+static std::vector<std::string> listFiles(const std::string& path) {
+    std::vector<std::string> result;
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) return result;
+
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            result.push_back(path + "/" + name);
+        }
+    }
+    closedir(dir);
+    return result;
+}
+
+static size_t packBytes(const std::string& directory) {
+    size_t result = 0;
+    for (const auto& file : listFiles(directory + "/packs")) {
+        struct stat fileStat {};
+        if (stat(file.c_str(), &fileStat) == 0) {
+            result += fileStat.st_size;
+        }
+    }
+    return result;
+}
+
+static bool readsBack(ChunkStore& store, const std::string& slot, const std::vector<int8_t>& expected) {
+    auto size = store.getSlotSize(slot);
+    if (!size.has_value() || size.value() != expected.size()) return false;
+
+    std::vector<int8_t> data(size.value());
+    return store.readSlot(slot, data.data(), data.size()) && data == expected;
+}
+
+static std::string createDirectory() {
+    char path[] = "/tmp/chunkstoretest-XXXXXX";
+    check(mkdtemp(path) != nullptr, "create temporary directory");
+    return path;
+}
+
+static void removeDirectory(const std::string& directory) {
+    for (const auto& subdirectory : { directory + "/slots", directory + "/packs" }) {
+        for (const auto& file : listFiles(subdirectory)) {
+            unlink(file.c_str());
+        }
+        rmdir(subdirectory.c_str());
+    }
+    rmdir(directory.c_str());
+}
+
+static void testRoundTrip() {
+    std::string directory = createDirectory();
+    auto state = makeState(1);
+
+    ChunkStore store(directory);
+    check(store.open(), "open empty store");
+    check(store.writeSlot("quick", state.data(), state.size()), "write slot");
+    check(readsBack(store, "quick", state), "slot reads back");
+    check(store.listSlots() == std::vector<std::string> { "quick" }, "slot is listed");
+
+    check(!store.getSlotSize("missing").has_value(), "missing slot has no size");
+    check(!store.writeSlot("../escape", state.data(), state.size()), "invalid slot name is rejected");
+
+    auto overwritten = makeState(2);
+    check(store.writeSlot("quick", overwritten.data(), overwritten.size()), "overwrite slot");
+    check(readsBack(store, "quick", overwritten), "overwritten slot reads back");
+
+    removeDirectory(directory);
+}
+
+static void testSimilarStatesShareChunks() {
+    std::string directory = createDirectory();
+    auto state = makeState(3);
+
+    ChunkStore store(directory);
+    check(store.open(), "open empty store");
+    check(store.writeSlot("first", state.data(), state.size()), "write first slot");
+    size_t firstBytes = packBytes(directory);
+    check(firstBytes >= STATE_SIZE, "random state is stored in full");
+
+    check(store.writeSlot("copy", state.data(), state.size()), "write identical slot");
+    check(packBytes(directory) == firstBytes, "identical state adds no chunks");
+
+    // Inserting bytes shifts the rest of the state, content defined chunks realign right after.
+    auto shifted = state;
+    shifted.insert(shifted.begin() + STATE_SIZE / 2, 3, 0x11);
+    shifted[1000] ^= 0x01;
+    check(store.writeSlot("shifted", shifted.data(), shifted.size()), "write shifted slot");
+    check(packBytes(directory) - firstBytes < STATE_SIZE / 8, "shifted state shares most chunks");
+
+    check(readsBack(store, "first", state), "first slot is intact");
+    check(readsBack(store, "copy", state), "identical slot is intact");
+    check(readsBack(store, "shifted", shifted), "shifted slot is intact");
+
+    removeDirectory(directory);
+}
+
+static void testGarbageCollection() {
+    std::string directory = createDirectory();
+    auto first = makeState(4);
+    auto second = makeState(5);
+
+    ChunkStore store(directory);
+    check(store.open(), "open empty store");
+    check(store.writeSlot("first", first.data(), first.size()), "write first slot");
+    check(store.writeSlot("second", second.data(), second.size()), "write second slot");
+    check(store.collectGarbage() == 0, "referenced chunks are kept");
+
+    size_t bytesBefore = packBytes(directory);
+    check(store.deleteSlot("first"), "delete slot");
+    check(!store.getSlotSize("first").has_value(), "deleted slot is gone");
+    check(packBytes(directory) == bytesBefore, "deleting does not touch the packs");
+
+    check(store.collectGarbage() > 0, "unreferenced chunks are collected");
+    check(packBytes(directory) < bytesBefore / 2 + STATE_SIZE / 8, "collected chunks free space");
+    check(readsBack(store, "second", second), "surviving slot is intact");
+
+    check(store.deleteSlot("second"), "delete last slot");
+    store.collectGarbage();
+    check(listFiles(directory + "/packs").empty(), "empty store has no packs");
+
+    removeDirectory(directory);
+}
+
+static void testReopen() {
+    std::string directory = createDirectory();
+    auto state = makeState(6);
+    auto other = makeState(7);
+
+    {
+        ChunkStore store(directory);
+        check(store.open(), "open empty store");
+        check(store.writeSlot("kept", state.data(), state.size()), "write kept slot");
+        check(store.writeSlot("deleted", other.data(), other.size()), "write deleted slot");
+        check(store.deleteSlot("deleted"), "delete slot");
+    }
+
+    // A crash while appending leaves a partial record at the end of a pack.
+    auto packs = listFiles(directory + "/packs");
+    check(!packs.empty(), "packs are written");
+    if (!packs.empty()) {
+        int fd = open(packs.front().c_str(), O_WRONLY | O_APPEND);
+        check(fd >= 0 && write(fd, "partial", 7) == 7, "append partial record");
+        close(fd);
+    }
+
+    ChunkStore store(directory);
+    check(store.open(), "reopen store");
+    check(readsBack(store, "kept", state), "slot survives reopening");
+    check(store.listSlots() == std::vector<std::string> { "kept" }, "deleted slot stays deleted");
+    check(store.collectGarbage() > 0, "references are rebuilt from the manifests");
+    check(readsBack(store, "kept", state), "slot survives garbage collection");
+
+    removeDirectory(directory);
+}
+
+} //namespace libretrodroid
+
+int main() {
+    using namespace libretrodroid;
+
+    testRoundTrip();
+    testSimilarStatesShareChunks();
+    testGarbageCollection();
+    testReopen();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
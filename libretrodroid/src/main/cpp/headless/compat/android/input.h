@@ -0,0 +1,29 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Subset of the NDK input constants used by the frontend.
+
+#ifndef LIBRETRODROID_HEADLESS_ANDROID_INPUT_H
+#define LIBRETRODROID_HEADLESS_ANDROID_INPUT_H
+
+enum {
+    AKEY_EVENT_ACTION_DOWN = 0,
+    AKEY_EVENT_ACTION_UP = 1,
+    AKEY_EVENT_ACTION_MULTIPLE = 2,
+};
+
+#endif //LIBRETRODROID_HEADLESS_ANDROID_INPUT_H
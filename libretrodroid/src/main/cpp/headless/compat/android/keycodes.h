@@ -0,0 +1,46 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Subset of the NDK key codes used by the frontend. Values match android/keycodes.h.
+
+#ifndef LIBRETRODROID_HEADLESS_ANDROID_KEYCODES_H
+#define LIBRETRODROID_HEADLESS_ANDROID_KEYCODES_H
+
+enum {
+    AKEYCODE_DPAD_UP = 19,
+    AKEYCODE_DPAD_DOWN = 20,
+    AKEYCODE_DPAD_LEFT = 21,
+    AKEYCODE_DPAD_RIGHT = 22,
+    AKEYCODE_BUTTON_A = 96,
+    AKEYCODE_BUTTON_B = 97,
+    AKEYCODE_BUTTON_X = 99,
+    AKEYCODE_BUTTON_Y = 100,
+    AKEYCODE_BUTTON_L1 = 102,
+    AKEYCODE_BUTTON_R1 = 103,
+    AKEYCODE_BUTTON_L2 = 104,
+    AKEYCODE_BUTTON_R2 = 105,
+    AKEYCODE_BUTTON_THUMBL = 106,
+    AKEYCODE_BUTTON_THUMBR = 107,
+    AKEYCODE_BUTTON_START = 108,
+    AKEYCODE_BUTTON_SELECT = 109,
+    AKEYCODE_DPAD_UP_LEFT = 268,
+    AKEYCODE_DPAD_DOWN_LEFT = 269,
+    AKEYCODE_DPAD_UP_RIGHT = 270,
+    AKEYCODE_DPAD_DOWN_RIGHT = 271,
+};
+
+#endif //LIBRETRODROID_HEADLESS_ANDROID_KEYCODES_H
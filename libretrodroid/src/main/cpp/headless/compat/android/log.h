@@ -0,0 +1,56 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Minimal replacement of the NDK logging API, used to build the frontend on a desktop host.
+
+#ifndef LIBRETRODROID_HEADLESS_ANDROID_LOG_H
+#define LIBRETRODROID_HEADLESS_ANDROID_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+} android_LogPriority;
+
+static inline int __android_log_vprint(int priority, const char* tag, const char* fmt, va_list args) {
+    static const char priorities[] = { ' ', ' ', 'V', 'D', 'I', 'W', 'E', 'F', ' ' };
+    char priorityChar = priority >= 0 && priority <= ANDROID_LOG_SILENT ? priorities[priority] : ' ';
+
+    fprintf(stderr, "%c/%s: ", priorityChar, tag);
+    int result = vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    return result;
+}
+
+static inline int __android_log_print(int priority, const char* tag, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int result = __android_log_vprint(priority, tag, fmt, args);
+    va_end(args);
+    return result;
+}
+
+#endif //LIBRETRODROID_HEADLESS_ANDROID_LOG_H
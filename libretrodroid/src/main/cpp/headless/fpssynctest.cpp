@@ -0,0 +1,195 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Drives FPSSync with a fake clock, so frame pacing can be checked without depending on the
+// scheduler of the host.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+#include "fpssync.h"
+
+namespace libretrodroid {
+
+// Time only moves when FPSSync sleeps or spins, or when the test simulates work. Every sleep
+// overshoots its target by a fixed amount, like a coarse system timer would.
+class FakeClock : public FPSSync::Clock {
+public:
+    explicit FakeClock(std::chrono::microseconds oversleep) : oversleep(oversleep) { }
+
+    TimePoint now() override {
+        return current;
+    }
+
+    void sleepUntil(TimePoint timePoint) override {
+        current = std::max(current, timePoint + oversleep);
+    }
+
+    void spinUntil(TimePoint timePoint) override {
+        current = std::max(current, timePoint);
+    }
+
+    void advance(std::chrono::microseconds duration) {
+        current += duration;
+    }
+
+private:
+    TimePoint current = TimePoint() + std::chrono::seconds(1);
+    std::chrono::microseconds oversleep;
+};
+
+static int failures = 0;
+
+static void check(bool condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", message);
+        failures++;
+    }
+}
+
+static void testPrecisePacingHitsDeadlines() {
+    auto clock = std::make_unique<FakeClock>(std::chrono::microseconds(200));
+    FakeClock* fakeClock = clock.get();
+    FPSSync fpsSync(60.0, 120.0, false, true, std::move(clock));
+
+    TimePoint start = fakeClock->now();
+    for (int i = 0; i < 600; i++) {
+        check(fpsSync.advanceFrames() == 1, "on time frames advance by one");
+        fakeClock->advance(std::chrono::microseconds(5000));
+        fpsSync.wait();
+    }
+
+    auto elapsed = std::chrono::duration<double>(fakeClock->now() - start).count();
+    check(std::abs(elapsed - 10.0) < 0.001, "600 frames at 60 fps take ten seconds");
+
+    auto stats = fpsSync.getStats();
+    check(stats.frames == 600, "every wait is recorded");
+    check(stats.lateFrames == 0, "no frame is late");
+    check(stats.maxError < 1.0, "frames end on their deadline");
+}
+
+static void testPrecisePacingCatchesUp() {
+    auto clock = std::make_unique<FakeClock>(std::chrono::microseconds(0));
+    FakeClock* fakeClock = clock.get();
+    FPSSync fpsSync(60.0, 120.0, false, true, std::move(clock));
+
+    fpsSync.advanceFrames();
+    fpsSync.wait();
+
+    // A stall of three and a half frames has to be recovered by skipping whole frames only.
+    fakeClock->advance(std::chrono::microseconds(58333));
+    check(fpsSync.advanceFrames() == 3, "a long stall advances by the number of missed frames");
+    check(fpsSync.getLateness() >= 3.0 && fpsSync.getLateness() < 4.0, "lateness is reported in frames");
+
+    fpsSync.wait();
+    check(fpsSync.advanceFrames() == 1, "pacing is back to one frame after catching up");
+    check(fpsSync.getLateness() < 1.0, "lateness is cleared after catching up");
+}
+
+static void testStoppedSleepDoesNotHang() {
+    // A clock whose sleep returns immediately leaves the whole interval to the spin.
+    class NoSleepClock : public FakeClock {
+    public:
+        NoSleepClock() : FakeClock(std::chrono::microseconds(0)) { }
+        void sleepUntil(TimePoint) override { }
+    };
+
+    auto clock = std::make_unique<NoSleepClock>();
+    FakeClock* fakeClock = clock.get();
+    FPSSync fpsSync(50.0, 60.0, false, true, std::move(clock));
+
+    TimePoint start = fakeClock->now();
+    for (int i = 0; i < 50; i++) {
+        fpsSync.advanceFrames();
+        fpsSync.wait();
+    }
+
+    auto elapsed = std::chrono::duration<double>(fakeClock->now() - start).count();
+    check(std::abs(elapsed - 1.0) < 0.001, "50 frames at 50 fps take one second");
+}
+
+static void testRefreshRateChange() {
+    auto clock = std::make_unique<FakeClock>(std::chrono::microseconds(100));
+    FakeClock* fakeClock = clock.get();
+    FPSSync fpsSync(60.0, 120.0, false, true, std::move(clock));
+
+    fpsSync.advanceFrames();
+    fpsSync.wait();
+
+    TimePoint changeTime = fakeClock->now();
+    fpsSync.setContentRefreshRate(50.0);
+    for (int i = 0; i < 50; i++) {
+        fpsSync.advanceFrames();
+        fpsSync.wait();
+    }
+
+    // Deadlines are counted again from the last one reached at 60 fps.
+    auto elapsed = std::chrono::duration<double>(fakeClock->now() - changeTime).count();
+    check(std::abs(elapsed - 1.0) < 0.001, "the new rate applies from the next frame");
+    check(fpsSync.getStats().lateFrames == 0, "changing rate does not produce late frames");
+}
+
+static void testSimplePacing() {
+    auto clock = std::make_unique<FakeClock>(std::chrono::microseconds(0));
+    FakeClock* fakeClock = clock.get();
+    FPSSync fpsSync(60.0, 120.0, false, false, std::move(clock));
+
+    TimePoint start = fakeClock->now();
+    for (int i = 0; i < 60; i++) {
+        check(fpsSync.advanceFrames() == 1, "on time frames advance by one");
+        fpsSync.wait();
+    }
+
+    auto elapsed = std::chrono::duration<double>(fakeClock->now() - start).count();
+    check(std::abs(elapsed - 1.0) < 0.001, "60 frames at 60 fps take one second");
+}
+
+static void testVSync() {
+    auto clock = std::make_unique<FakeClock>(std::chrono::microseconds(0));
+    FakeClock* fakeClock = clock.get();
+    FPSSync fpsSync(60.0, 60.0, true, true, std::move(clock));
+
+    TimePoint start = fakeClock->now();
+    check(fpsSync.isUsingVSync(), "matching refresh rates use vsync");
+    check(fpsSync.advanceFrames() == 1, "vsync always advances by one");
+    fpsSync.wait();
+    check(fakeClock->now() == start, "vsync never waits");
+}
+
+} //namespace libretrodroid
+
+int main() {
+    using namespace libretrodroid;
+
+    testPrecisePacingHitsDeadlines();
+    testPrecisePacingCatchesUp();
+    testStoppedSleepDoesNotHang();
+    testRefreshRateChange();
+    testSimplePacing();
+    testVSync();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
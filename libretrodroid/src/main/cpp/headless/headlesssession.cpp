@@ -0,0 +1,256 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "headlesssession.h"
+
+#include <fcntl.h>
+#include <stdexcept>
+
+#include "log.h"
+
+namespace libretrodroid {
+
+HeadlessSession::Scope::Scope(HeadlessSession* session):
+    sessionBinding(session),
+    environmentBinding(&session->environment),
+    vfsBinding(&session->vfs),
+    perfCountersBinding(&session->perfCounters) { }
+
+HeadlessSession::HeadlessSession(const Options& options) {
+    Scope scope(this);
+
+    environment.initialize(
+        options.systemDirectory,
+        options.savesDirectory,
+        &callback_get_current_framebuffer
+    );
+
+    // Frames are run back to back, without any pacing.
+    environment.setThrottleState(RETRO_THROTTLE_UNBLOCKED, 0.0f);
+
+    for (const auto& variable : options.variables) {
+        environment.updateVariable(variable.key, variable.value);
+    }
+
+    core = std::make_unique<Core>(options.corePath, true);
+    core->retro_set_environment(&Environment::callback_environment);
+    core->retro_set_video_refresh(&callback_video_refresh);
+    core->retro_set_audio_sample(&callback_audio_sample);
+    core->retro_set_audio_sample_batch(&callback_audio_sample_batch);
+    core->retro_set_input_poll(&callback_input_poll);
+    core->retro_set_input_state(&callback_input_state);
+
+    core->retro_init();
+
+    bool gameLoaded = false;
+    try {
+        loadGame(options.gamePath);
+        gameLoaded = true;
+
+        if (!options.moviePath.empty()) {
+            startMovie(options.moviePath);
+        }
+    } catch (...) {
+        if (gameLoaded) {
+            core->retro_unload_game();
+        }
+        core->retro_deinit();
+        perfCounters.clear();
+        throw;
+    }
+}
+
+HeadlessSession::~HeadlessSession() {
+    Scope scope(this);
+
+    moviePlayer = nullptr;
+
+    core->retro_unload_game();
+    gameFile = nullptr;
+    core->retro_deinit();
+    perfCounters.clear();
+    core = nullptr;
+
+    environment.deinitialize();
+}
+
+void HeadlessSession::loadGame(const std::string& gamePath) {
+    struct retro_system_info system_info {};
+    core->retro_get_system_info(&system_info);
+
+    struct retro_game_info game_info {};
+    game_info.path = gamePath.c_str();
+    game_info.meta = nullptr;
+
+    if (!system_info.need_fullpath) {
+        gameFile = MappedFile::open(gamePath);
+        game_info.data = gameFile->getData();
+        game_info.size = gameFile->getSize();
+    }
+
+    if (!core->retro_load_game(&game_info)) {
+        gameFile = nullptr;
+        throw std::runtime_error("Cannot load game");
+    }
+}
+
+void HeadlessSession::startMovie(const std::string& moviePath) {
+    int fd = open(moviePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open input movie");
+    }
+
+    moviePlayer = InputMoviePlayer::create(fd);
+    if (!moviePlayer) {
+        throw std::runtime_error("Invalid input movie");
+    }
+
+    if (!core->retro_unserialize(moviePlayer->getState(), moviePlayer->getStateSize())) {
+        throw std::runtime_error("Cannot restore the initial state of the input movie");
+    }
+}
+
+void HeadlessSession::runFrame() {
+    Scope scope(this);
+
+    if (moviePlayer) {
+        moviePlayer->beginFrame();
+    }
+
+    // Audio is not played, so cores should not skip frames because of it.
+    auto audioBufferStatusCallback = environment.getAudioBufferStatusCallback();
+    if (audioBufferStatusCallback) {
+        audioBufferStatusCallback(false, 0, false);
+    }
+
+    core->retro_run();
+
+    // The frontend drains the environment events once per frame, we do the same to keep the queue
+    // from overflowing.
+    environment.drainEvents([](EnvironmentEvent&) { });
+}
+
+struct retro_system_info HeadlessSession::getSystemInfo() {
+    Scope scope(this);
+
+    struct retro_system_info result {};
+    core->retro_get_system_info(&result);
+    return result;
+}
+
+struct retro_system_av_info HeadlessSession::getSystemAVInfo() {
+    Scope scope(this);
+
+    struct retro_system_av_info result {};
+    core->retro_get_system_av_info(&result);
+    return result;
+}
+
+void HeadlessSession::setVideoHandler(VideoHandler handler) {
+    videoHandler = std::move(handler);
+}
+
+void HeadlessSession::setAudioHandler(AudioHandler handler) {
+    audioHandler = std::move(handler);
+}
+
+int HeadlessSession::getPixelFormat() const {
+    return environment.getPixelFormat();
+}
+
+const HeadlessSession::Counters& HeadlessSession::getCounters() const {
+    return counters;
+}
+
+void HeadlessSession::resetCounters() {
+    counters = Counters {};
+    perfCounters.reset();
+}
+
+PerfCounters& HeadlessSession::getPerfCounters() {
+    return perfCounters;
+}
+
+const InputMoviePlayer* HeadlessSession::getMoviePlayer() const {
+    return moviePlayer.get();
+}
+
+// Callbacks coming from threads spawned by the core cannot be attributed to a session and are
+// ignored.
+HeadlessSession* HeadlessSession::getCurrent() {
+    HeadlessSession* result = ThreadBinding<HeadlessSession>::get();
+    if (!result) {
+        LOGW("Ignoring libretro callback invoked outside of a session");
+    }
+    return result;
+}
+
+void HeadlessSession::callback_video_refresh(const void* data, unsigned width, unsigned height, size_t pitch) {
+    HeadlessSession* session = getCurrent();
+    if (!session) return;
+
+    session->counters.videoFrames++;
+    session->counters.duplicatedFrames += data == nullptr ? 1 : 0;
+
+    if (session->videoHandler) {
+        session->videoHandler(data, width, height, pitch);
+    }
+}
+
+void HeadlessSession::callback_audio_sample(int16_t left, int16_t right) {
+    HeadlessSession* session = getCurrent();
+    if (!session) return;
+
+    session->counters.audioFrames++;
+
+    if (session->audioHandler) {
+        int16_t frame[2] = { left, right };
+        session->audioHandler(frame, 1);
+    }
+}
+
+size_t HeadlessSession::callback_audio_sample_batch(const int16_t* data, size_t frames) {
+    HeadlessSession* session = getCurrent();
+    if (!session) return frames;
+
+    session->counters.audioFrames += frames;
+
+    if (session->audioHandler) {
+        session->audioHandler(data, frames);
+    }
+    return frames;
+}
+
+void HeadlessSession::callback_input_poll() { }
+
+int16_t HeadlessSession::callback_input_state(unsigned port, unsigned device, unsigned index, unsigned id) {
+    HeadlessSession* session = getCurrent();
+    if (!session) return 0;
+
+    session->counters.inputQueries++;
+    if (session->moviePlayer) {
+        return session->moviePlayer->getInputState(port, device, index, id);
+    }
+    return session->input.getInputState(port, device, index, id);
+}
+
+uintptr_t HeadlessSession::callback_get_current_framebuffer() {
+    return 0;
+}
+
+} //namespace libretrodroid
@@ -0,0 +1,129 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_HEADLESSSESSION_H
+#define LIBRETRODROID_HEADLESSSESSION_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core.h"
+#include "environment.h"
+#include "input.h"
+#include "inputmovie.h"
+#include "perfcounters.h"
+#include "utils/mappedfile.h"
+#include "vfs/vfs.h"
+
+namespace libretrodroid {
+
+// A libretro core running without any Android dependency. Every session owns its environment and
+// a private copy of the core, so several of them can run on different threads of the same process.
+// A session must not be used by more than one thread at a time.
+class HeadlessSession {
+public:
+    struct Options {
+        std::string corePath;
+        std::string gamePath;
+        std::string systemDirectory = ".";
+        std::string savesDirectory = ".";
+        std::vector<Variable> variables;
+        std::string moviePath;
+    };
+
+    struct Counters {
+        uint64_t videoFrames = 0;
+        uint64_t duplicatedFrames = 0;
+        uint64_t audioFrames = 0;
+        uint64_t inputQueries = 0;
+    };
+
+    // Duplicated frames are reported with null data.
+    using VideoHandler = std::function<void(const void* data, unsigned width, unsigned height, size_t pitch)>;
+    using AudioHandler = std::function<void(const int16_t* data, size_t frames)>;
+
+    explicit HeadlessSession(const Options& options);
+    ~HeadlessSession();
+    HeadlessSession(HeadlessSession const&) = delete;
+    void operator=(HeadlessSession const&) = delete;
+
+    void runFrame();
+
+    void setVideoHandler(VideoHandler handler);
+    void setAudioHandler(AudioHandler handler);
+
+    // One of the RETRO_PIXEL_FORMAT values.
+    int getPixelFormat() const;
+
+    struct retro_system_info getSystemInfo();
+    struct retro_system_av_info getSystemAVInfo();
+
+    const Counters& getCounters() const;
+    void resetCounters();
+
+    PerfCounters& getPerfCounters();
+
+    // Null when the session is not replaying an input movie.
+    const InputMoviePlayer* getMoviePlayer() const;
+
+private:
+    // Routes the libretro callbacks issued by the calling thread to this session.
+    class Scope {
+    public:
+        explicit Scope(HeadlessSession* session);
+
+    private:
+        ThreadBinding<HeadlessSession>::Scope sessionBinding;
+        Environment::Binding::Scope environmentBinding;
+        VFS::Binding::Scope vfsBinding;
+        PerfCounters::Binding::Scope perfCountersBinding;
+    };
+
+    void loadGame(const std::string& gamePath);
+    void startMovie(const std::string& moviePath);
+
+    static HeadlessSession* getCurrent();
+
+    static void callback_video_refresh(const void* data, unsigned width, unsigned height, size_t pitch);
+    static void callback_audio_sample(int16_t left, int16_t right);
+    static size_t callback_audio_sample_batch(const int16_t* data, size_t frames);
+    static void callback_input_poll();
+    static int16_t callback_input_state(unsigned port, unsigned device, unsigned index, unsigned id);
+    static uintptr_t callback_get_current_framebuffer();
+
+private:
+    Environment environment;
+    VFS vfs;
+    PerfCounters perfCounters;
+    Input input;
+    Counters counters;
+    VideoHandler videoHandler;
+    AudioHandler audioHandler;
+    std::unique_ptr<InputMoviePlayer> moviePlayer;
+    std::unique_ptr<Core> core;
+
+    // The core might reference the game data until it is unloaded.
+    std::unique_ptr<MappedFile> gameFile;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_HEADLESSSESSION_H
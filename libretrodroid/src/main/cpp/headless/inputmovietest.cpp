@@ -0,0 +1,203 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Records synthetic input movies into temporary files and replays them. Truncated movies, like
+// the ones left behind when the application is killed while recording, must replay up to the
+// last complete frame.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "inputmovie.h"
+
+namespace libretrodroid {
+
+static int failures = 0;
+
+static void check(bool condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", message);
+        failures++;
+    }
+}
+
+// Enough frames to fill several recorder blocks. The last frame polls the input after a frame
+// which did not, so it is stored in full.
+static constexpr unsigned FRAMES = 6001;
+static constexpr unsigned BUTTONS = 16;
+
+static const InputMovie::Header HEADER { "testcore", "1.0.0", 0xCAFEBABE };
+static const std::vector<int8_t> STATE { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+// Buttons change every few frames, so the movie contains both full and repeated frames. Every
+// tenth frame the core does not poll the input at all.
+static int16_t buttonValue(unsigned frame, unsigned button) {
+    return (int16_t) (((frame / 7) + button) % 3 == 0);
+}
+
+static bool pollsInput(unsigned frame) {
+    return frame % 10 != 9;
+}
+
+static std::string createFile() {
+    char path[] = "/tmp/inputmovietest-XXXXXX";
+    int fd = mkstemp(path);
+    check(fd >= 0, "create temporary file");
+    close(fd);
+    return path;
+}
+
+static void recordMovie(const std::string& path) {
+    int fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+    auto recorder = InputMovieRecorder::create(fd, HEADER, STATE.data(), STATE.size());
+    check(recorder != nullptr, "create recorder");
+    if (!recorder) return;
+
+    for (unsigned frame = 0; frame < FRAMES; frame++) {
+        if (pollsInput(frame)) {
+            for (unsigned button = 0; button < BUTTONS; button++) {
+                recorder->record(0, 1, 0, button, buttonValue(frame, button));
+            }
+        }
+        recorder->endFrame();
+    }
+
+    check(recorder->finish(), "finish recording");
+}
+
+static std::unique_ptr<InputMoviePlayer> openMovie(const std::string& path) {
+    return InputMoviePlayer::create(open(path.c_str(), O_RDONLY));
+}
+
+static unsigned replayMovie(InputMoviePlayer& player) {
+    unsigned frames = 0;
+    bool matches = true;
+    while (player.beginFrame()) {
+        if (pollsInput(frames)) {
+            for (unsigned button = 0; button < BUTTONS; button++) {
+                matches = matches && player.getInputState(0, 1, 0, button) == buttonValue(frames, button);
+            }
+        }
+        frames++;
+    }
+    check(matches, "replayed inputs match the recorded ones");
+    return frames;
+}
+
+static void truncateFile(const std::string& path, off_t size) {
+    check(truncate(path.c_str(), size) == 0, "truncate movie");
+}
+
+static off_t fileSize(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    off_t result = lseek(fd, 0, SEEK_END);
+    close(fd);
+    return result;
+}
+
+static void testRoundTrip() {
+    std::string path = createFile();
+    recordMovie(path);
+
+    auto player = openMovie(path);
+    check(player != nullptr, "open movie");
+    if (!player) return;
+
+    check(player->getHeader().coreName == HEADER.coreName, "core name is preserved");
+    check(player->getHeader().coreVersion == HEADER.coreVersion, "core version is preserved");
+    check(player->getHeader().romCrc == HEADER.romCrc, "rom crc is preserved");
+    check(std::vector<int8_t>(player->getState(), player->getState() + player->getStateSize()) == STATE, "state is preserved");
+
+    check(replayMovie(*player) == FRAMES, "all frames are replayed");
+    check(player->getFrames() == FRAMES, "frames are counted");
+    check(player->getMismatches() == 0, "deterministic replay has no mismatches");
+    check(player->getInputState(0, 1, 0, 0) == 0, "finished movie returns no input");
+
+    unlink(path.c_str());
+}
+
+static void testMismatchedQueries() {
+    std::string path = createFile();
+    recordMovie(path);
+
+    auto player = openMovie(path);
+    check(player != nullptr && player->beginFrame(), "open movie");
+    if (!player) return;
+
+    check(player->getInputState(0, 1, 0, 3) == buttonValue(0, 3), "out of order query finds the value");
+    check(player->getInputState(1, 1, 0, 0) == 0, "unknown query returns no input");
+    check(player->getMismatches() == 2, "unexpected queries are counted");
+
+    unlink(path.c_str());
+}
+
+static void testTruncatedFrames() {
+    std::string path = createFile();
+    recordMovie(path);
+
+    // Cuts the last frame in the middle of its records.
+    truncateFile(path, fileSize(path) - 2 * InputMovie::RECORD_SIZE);
+
+    auto player = openMovie(path);
+    check(player != nullptr, "truncated movie can be opened");
+    if (!player) return;
+
+    unsigned frames = replayMovie(*player);
+    check(frames == FRAMES - 1, "replay stops at the truncated frame");
+    check(!player->beginFrame(), "truncated movie stays finished");
+
+    unlink(path.c_str());
+}
+
+static void testTruncatedHeader() {
+    std::string path = createFile();
+    recordMovie(path);
+
+    off_t stateEnd = 4 + 2 + 2 + (4 + 8) + (4 + 5) + 4 + 8 + STATE.size();
+    truncateFile(path, stateEnd - 1);
+    check(openMovie(path) == nullptr, "movie without the whole state is rejected");
+
+    truncateFile(path, 10);
+    check(openMovie(path) == nullptr, "movie without the whole header is rejected");
+
+    unlink(path.c_str());
+}
+
+} //namespace libretrodroid
+
+int main() {
+    using namespace libretrodroid;
+
+    testRoundTrip();
+    testMismatchedQueries();
+    testTruncatedFrames();
+    testTruncatedHeader();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,600 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+// Runs a batch of libretro jobs and checks that their output did not change. Every job runs in its
+// own worker process, so crashes and hangs only affect the job that caused them. Video frames and
+// audio samples are hashed while the job runs and the cumulative hashes are sampled at regular
+// checkpoints: comparing them with a previous run points to the first checkpoint where the output
+// diverged.
+//
+// Usage: libretrodroid-regression <manifest> [--jobs N] [--checkpoint-interval N] [--timeout SECONDS]
+//                                 [--system-dir DIR] [--saves-dir DIR] [--record FILE]
+//                                 [--expect FILE] [--max-slowdown PERCENT]
+//
+// The manifest contains one job per line, in the form "<name> <core.so> <game> <frames> [movie]".
+// Empty lines and lines starting with # are ignored. Paths are relative to the working directory.
+//
+// --record stores hashes and throughput of every job, --expect compares the run with a recorded
+// one. With --max-slowdown a job also fails when its frame rate drops by more than the given
+// percentage. The report is printed as JSON and the exit code is non zero if any job failed.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "headlesssession.h"
+#include "log.h"
+
+namespace libretrodroid {
+
+struct RegressionJob {
+    std::string name;
+    std::string corePath;
+    std::string gamePath;
+    unsigned frames = 0;
+    std::string moviePath;
+};
+
+struct RegressionOptions {
+    std::string manifestPath;
+    unsigned jobs = 0;
+    unsigned checkpointInterval = 600;
+    unsigned timeoutSeconds = 600;
+    std::string systemDirectory = ".";
+    std::string savesDirectory = "regression-saves";
+    std::string recordPath;
+    std::string expectPath;
+    double maxSlowdown = -1.0;
+};
+
+struct Checkpoint {
+    unsigned frame;
+    uint64_t videoHash;
+    uint64_t audioHash;
+};
+
+struct JobResult {
+    std::vector<Checkpoint> checkpoints;
+    double seconds = 0.0;
+    double fps = 0.0;
+    double contentFps = 0.0;
+    std::string error;
+};
+
+// Streaming 64 bit hash, fed one word at a time. Values are mixed with a Murmur3 style finalizer
+// when sampled, so that consecutive checkpoints do not look alike.
+class OutputHash {
+public:
+    void update(const uint8_t* data, size_t size) {
+        size_t offset = 0;
+        for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data + offset, sizeof(word));
+            update(word);
+        }
+
+        uint64_t tail = 0;
+        if (offset < size) {
+            memcpy(&tail, data + offset, size - offset);
+            update(tail ^ ((uint64_t) (size - offset) << 56));
+        }
+    }
+
+    void update(uint64_t word) {
+        state = (state ^ word) * 0x100000001b3ULL;
+        state = (state << 31) | (state >> 33);
+    }
+
+    uint64_t getValue() const {
+        uint64_t result = state;
+        result ^= result >> 33;
+        result *= 0xff51afd7ed558ccdULL;
+        result ^= result >> 33;
+        result *= 0xc4ceb9fe1a85ec53ULL;
+        result ^= result >> 33;
+        return result;
+    }
+
+private:
+    uint64_t state = 0xcbf29ce484222325ULL;
+};
+
+static uint64_t parseHex(const std::string& value) {
+    return std::strtoull(value.c_str(), nullptr, 16);
+}
+
+static std::string toHex(uint64_t value) {
+    char result[17];
+    snprintf(result, sizeof(result), "%016llx", (unsigned long long) value);
+    return result;
+}
+
+static void makeDirectory(const std::string& path) {
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Cannot create directory " + path);
+    }
+}
+
+static std::vector<RegressionJob> parseManifest(const std::string& manifestPath) {
+    std::ifstream manifest(manifestPath);
+    if (!manifest) {
+        throw std::invalid_argument("Cannot open manifest " + manifestPath);
+    }
+
+    std::vector<RegressionJob> result;
+    std::unordered_set<std::string> names;
+
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(manifest, line)) {
+        lineNumber++;
+
+        std::istringstream fields(line);
+        RegressionJob job;
+        if (!(fields >> job.name) || job.name[0] == '#') {
+            continue;
+        }
+
+        if (!(fields >> job.corePath >> job.gamePath >> job.frames) || job.frames == 0) {
+            throw std::invalid_argument("Invalid job at line " + std::to_string(lineNumber));
+        }
+        fields >> job.moviePath;
+
+        if (!names.insert(job.name).second) {
+            throw std::invalid_argument("Duplicated job " + job.name);
+        }
+        result.push_back(job);
+    }
+    return result;
+}
+
+// Records contain "<name> checkpoint <frame> <video> <audio>" and "<name> fps <value>" lines.
+static std::unordered_map<std::string, JobResult> readRecord(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) {
+        throw std::invalid_argument("Cannot open record " + path);
+    }
+
+    std::unordered_map<std::string, JobResult> result;
+    std::string name;
+    std::string type;
+    while (input >> name >> type) {
+        if (type == "checkpoint") {
+            Checkpoint checkpoint {};
+            std::string video;
+            std::string audio;
+            input >> checkpoint.frame >> video >> audio;
+            checkpoint.videoHash = parseHex(video);
+            checkpoint.audioHash = parseHex(audio);
+            result[name].checkpoints.push_back(checkpoint);
+        } else if (type == "fps") {
+            input >> result[name].fps;
+        } else {
+            throw std::invalid_argument("Invalid record " + path);
+        }
+    }
+    return result;
+}
+
+static void writeRecord(
+    const std::string& path,
+    const std::vector<RegressionJob>& jobs,
+    const std::vector<JobResult>& results
+) {
+    FILE* output = fopen(path.c_str(), "w");
+    if (!output) {
+        throw std::runtime_error("Cannot write record " + path);
+    }
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (!results[i].error.empty()) continue;
+
+        for (const auto& checkpoint : results[i].checkpoints) {
+            fprintf(
+                output,
+                "%s checkpoint %u %s %s\n",
+                jobs[i].name.c_str(),
+                checkpoint.frame,
+                toHex(checkpoint.videoHash).c_str(),
+                toHex(checkpoint.audioHash).c_str()
+            );
+        }
+        fprintf(output, "%s fps %.4f\n", jobs[i].name.c_str(), results[i].fps);
+    }
+    fclose(output);
+}
+
+static size_t getBytesPerPixel(int pixelFormat) {
+    return pixelFormat == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2;
+}
+
+// Runs inside the worker process. Results are written line by line to the given file, which the
+// runner reads once the worker has exited.
+static void runJob(const RegressionOptions& options, const RegressionJob& job, FILE* output) {
+    std::string savesDirectory = options.savesDirectory + "/" + job.name;
+    makeDirectory(savesDirectory);
+
+    HeadlessSession::Options sessionOptions;
+    sessionOptions.corePath = job.corePath;
+    sessionOptions.gamePath = job.gamePath;
+    sessionOptions.moviePath = job.moviePath;
+    sessionOptions.systemDirectory = options.systemDirectory;
+    sessionOptions.savesDirectory = savesDirectory;
+
+    HeadlessSession session(sessionOptions);
+
+    OutputHash videoHash;
+    OutputHash audioHash;
+
+    // Only the visible part of each line is hashed, and the unused byte of XRGB8888 pixels is
+    // masked since cores do not have to initialize it.
+    session.setVideoHandler([&](const void* data, unsigned width, unsigned height, size_t pitch) {
+        if (!data) {
+            videoHash.update(0);
+            return;
+        }
+
+        videoHash.update(((uint64_t) width << 32) | height);
+
+        auto pixels = (const uint8_t*) data;
+        size_t bytesPerPixel = getBytesPerPixel(session.getPixelFormat());
+        for (unsigned y = 0; y < height; y++) {
+            const uint8_t* line = pixels + y * pitch;
+            if (bytesPerPixel == 4) {
+                for (unsigned x = 0; x < width; x++) {
+                    uint32_t pixel;
+                    memcpy(&pixel, line + x * 4, sizeof(pixel));
+                    videoHash.update(pixel & 0x00ffffff);
+                }
+            } else {
+                videoHash.update(line, width * bytesPerPixel);
+            }
+        }
+    });
+
+    session.setAudioHandler([&](const int16_t* data, size_t frames) {
+        audioHash.update((const uint8_t*) data, frames * 2 * sizeof(int16_t));
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned frame = 1; frame <= job.frames; frame++) {
+        session.runFrame();
+
+        if (frame % options.checkpointInterval == 0 || frame == job.frames) {
+            fprintf(
+                output,
+                "checkpoint %u %s %s\n",
+                frame,
+                toHex(videoHash.getValue()).c_str(),
+                toHex(audioHash.getValue()).c_str()
+            );
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fprintf(output, "seconds %.6f\n", seconds);
+    fprintf(output, "fps %.4f\n", job.frames / seconds);
+    fprintf(output, "content_fps %.4f\n", session.getSystemAVInfo().timing.fps);
+}
+
+static pid_t startWorker(const RegressionOptions& options, const RegressionJob& job, FILE* output) {
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    // A hung worker is terminated by the default SIGALRM action.
+    alarm(options.timeoutSeconds);
+
+    int exitCode = 0;
+    try {
+        runJob(options, job, output);
+    } catch (std::exception& exception) {
+        fprintf(output, "error %s\n", exception.what());
+        exitCode = 1;
+    } catch (...) {
+        exitCode = 1;
+    }
+
+    fflush(output);
+    _exit(exitCode);
+}
+
+static JobResult collectWorker(FILE* output, int status) {
+    JobResult result;
+
+    rewind(output);
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), output)) {
+        std::istringstream line(buffer);
+        std::string type;
+        line >> type;
+
+        if (type == "checkpoint") {
+            Checkpoint checkpoint {};
+            std::string video;
+            std::string audio;
+            line >> checkpoint.frame >> video >> audio;
+            checkpoint.videoHash = parseHex(video);
+            checkpoint.audioHash = parseHex(audio);
+            result.checkpoints.push_back(checkpoint);
+        } else if (type == "seconds") {
+            line >> result.seconds;
+        } else if (type == "fps") {
+            line >> result.fps;
+        } else if (type == "content_fps") {
+            line >> result.contentFps;
+        } else if (type == "error") {
+            std::getline(line >> std::ws, result.error);
+        }
+    }
+
+    if (WIFSIGNALED(status)) {
+        int signal = WTERMSIG(status);
+        result.error = signal == SIGALRM ? "Timed out" : std::string("Crashed: ") + strsignal(signal);
+    } else if (result.error.empty() && (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+        result.error = "Worker failed";
+    }
+
+    return result;
+}
+
+static std::vector<JobResult> runJobs(const RegressionOptions& options, const std::vector<RegressionJob>& jobs) {
+    struct Worker {
+        size_t job;
+        FILE* output;
+    };
+
+    std::vector<JobResult> results(jobs.size());
+    std::unordered_map<pid_t, Worker> workers;
+    size_t nextJob = 0;
+
+    while (nextJob < jobs.size() || !workers.empty()) {
+        while (nextJob < jobs.size() && workers.size() < options.jobs) {
+            FILE* output = tmpfile();
+            if (!output) {
+                throw std::runtime_error("Cannot create worker output");
+            }
+
+            pid_t pid = startWorker(options, jobs[nextJob], output);
+            if (pid < 0) {
+                fclose(output);
+                throw std::runtime_error("Cannot start worker");
+            }
+
+            workers[pid] = Worker { nextJob, output };
+            nextJob++;
+        }
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Cannot wait for workers");
+        }
+
+        auto worker = workers.find(pid);
+        if (worker == workers.end()) continue;
+
+        size_t job = worker->second.job;
+        results[job] = collectWorker(worker->second.output, status);
+        fclose(worker->second.output);
+        workers.erase(worker);
+
+        LOGI("Job %s completed", jobs[job].name.c_str());
+    }
+
+    return results;
+}
+
+// Returns an empty string if the result matches the expected one.
+static std::string compareResult(
+    const RegressionOptions& options,
+    const RegressionJob& job,
+    const JobResult& result,
+    const JobResult* expected
+) {
+    if (!result.error.empty()) {
+        return result.error;
+    }
+
+    if (!expected) {
+        return "";
+    }
+
+    size_t count = std::min(result.checkpoints.size(), expected->checkpoints.size());
+    for (size_t i = 0; i < count; i++) {
+        const Checkpoint& actual = result.checkpoints[i];
+        const Checkpoint& reference = expected->checkpoints[i];
+
+        if (actual.frame != reference.frame) {
+            return "Checkpoints do not match the record";
+        }
+        if (actual.videoHash != reference.videoHash) {
+            return "Video mismatch at frame " + std::to_string(actual.frame);
+        }
+        if (actual.audioHash != reference.audioHash) {
+            return "Audio mismatch at frame " + std::to_string(actual.frame);
+        }
+    }
+
+    if (result.checkpoints.size() != expected->checkpoints.size()) {
+        return "Checkpoints do not match the record";
+    }
+
+    if (options.maxSlowdown >= 0.0 && expected->fps > 0.0) {
+        if (result.fps < expected->fps * (1.0 - options.maxSlowdown / 100.0)) {
+            char message[128];
+            snprintf(message, sizeof(message), "Frame rate dropped from %.2f to %.2f", expected->fps, result.fps);
+            return message;
+        }
+    }
+
+    return "";
+}
+
+static std::string escapeJson(const std::string& value) {
+    std::string result;
+    for (char c : value) {
+        if (c == '"' || c == '\\') result += '\\';
+        if ((unsigned char) c >= 0x20) result += c;
+    }
+    return result;
+}
+
+static int runRegression(const RegressionOptions& options) {
+    std::vector<RegressionJob> jobs = parseManifest(options.manifestPath);
+
+    std::unordered_map<std::string, JobResult> expected;
+    if (!options.expectPath.empty()) {
+        expected = readRecord(options.expectPath);
+    }
+
+    makeDirectory(options.savesDirectory);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<JobResult> results = runJobs(options, jobs);
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!options.recordPath.empty()) {
+        writeRecord(options.recordPath, jobs, results);
+    }
+
+    unsigned failures = 0;
+
+    printf("{\n");
+    printf("  \"jobs\": [\n");
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const auto& job = jobs[i];
+        const auto& result = results[i];
+
+        auto reference = expected.find(job.name);
+        std::string failure = compareResult(
+            options,
+            job,
+            result,
+            reference != expected.end() ? &reference->second : nullptr
+        );
+        failures += failure.empty() ? 0 : 1;
+
+        printf("    {\n");
+        printf("      \"name\": \"%s\",\n", escapeJson(job.name).c_str());
+        printf("      \"passed\": %s,\n", failure.empty() ? "true" : "false");
+        printf("      \"frames\": %u,\n", job.frames);
+        printf("      \"seconds\": %.6f,\n", result.seconds);
+        printf("      \"fps\": %.2f,\n", result.fps);
+        printf("      \"speed\": %.3f,\n", result.contentFps > 0.0 ? result.fps / result.contentFps : 0.0);
+        printf("      \"checked\": %s,\n", reference != expected.end() ? "true" : "false");
+        printf("      \"failure\": \"%s\"\n", escapeJson(failure).c_str());
+        printf("    }%s\n", i + 1 < jobs.size() ? "," : "");
+    }
+    printf("  ],\n");
+    printf("  \"total_seconds\": %.6f,\n", totalSeconds);
+    printf("  \"passed\": %zu,\n", jobs.size() - failures);
+    printf("  \"failed\": %u\n", failures);
+    printf("}\n");
+
+    return failures == 0 ? 0 : 1;
+}
+
+static RegressionOptions parseOptions(int argc, char** argv) {
+    RegressionOptions result;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--jobs" && hasValue) {
+            result.jobs = (unsigned) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--checkpoint-interval" && hasValue) {
+            result.checkpointInterval = (unsigned) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--timeout" && hasValue) {
+            result.timeoutSeconds = (unsigned) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--system-dir" && hasValue) {
+            result.systemDirectory = argv[++i];
+        } else if (arg == "--saves-dir" && hasValue) {
+            result.savesDirectory = argv[++i];
+        } else if (arg == "--record" && hasValue) {
+            result.recordPath = argv[++i];
+        } else if (arg == "--expect" && hasValue) {
+            result.expectPath = argv[++i];
+        } else if (arg == "--max-slowdown" && hasValue) {
+            result.maxSlowdown = std::strtod(argv[++i], nullptr);
+        } else if (arg.rfind("--", 0) == 0) {
+            throw std::invalid_argument("Unknown option " + arg);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 1) {
+        throw std::invalid_argument("A manifest is required");
+    }
+
+    if (result.checkpointInterval == 0) {
+        throw std::invalid_argument("The checkpoint interval must be positive");
+    }
+
+    if (result.jobs == 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        result.jobs = processors > 0 ? (unsigned) processors : 1;
+    }
+
+    result.manifestPath = positional[0];
+    return result;
+}
+
+} //namespace libretrodroid
+
+int main(int argc, char** argv) {
+    try {
+        auto options = libretrodroid::parseOptions(argc, argv);
+        return libretrodroid::runRegression(options);
+    } catch (std::invalid_argument& exception) {
+        fprintf(stderr, "%s\n", exception.what());
+        fprintf(
+            stderr,
+            "Usage: %s <manifest> [--jobs N] [--checkpoint-interval N] [--timeout SECONDS] "
+            "[--system-dir DIR] [--saves-dir DIR] [--record FILE] [--expect FILE] "
+            "[--max-slowdown PERCENT]\n",
+            argv[0]
+        );
+        return 2;
+    } catch (std::exception& exception) {
+        fprintf(stderr, "Regression failed: %s\n", exception.what());
+        return 1;
+    }
+}
@@ -0,0 +1,191 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Feeds RewindBuffer with synthetic states and checks that walking back restores each of them
+// byte for byte, including the trailing bytes which do not fill a whole delta word.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "rewindbuffer.h"
+
+namespace libretrodroid {
+
+static int failures = 0;
+
+static void check(bool condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", message);
+        failures++;
+    }
+}
+
+using State = std::vector<int8_t>;
+
+// Mixes unchanged states, sparse changes and fully rewritten states, which exercise all the
+// token kinds of the delta encoding.
+static std::vector<State> buildHistory(size_t stateSize, size_t count) {
+    std::mt19937 random(1234);
+    std::vector<State> result;
+
+    State state(stateSize, 0);
+    for (size_t i = 0; i < count; i++) {
+        switch (i % 4) {
+            case 0:
+                break;
+            case 1:
+                state[random() % stateSize] ^= 0x5A;
+                state[stateSize - 1] = (int8_t) i;
+                break;
+            case 2:
+                for (size_t j = random() % 64; j < stateSize; j += 97) {
+                    state[j] = (int8_t) random();
+                }
+                break;
+            case 3:
+                for (auto& value : state) {
+                    value = (int8_t) random();
+                }
+                break;
+        }
+        result.push_back(state);
+    }
+    return result;
+}
+
+static void push(RewindBuffer& buffer, const State& state) {
+    auto [data, size] = buffer.beginSnapshot();
+    memcpy(data, state.data(), size);
+    buffer.commitSnapshot();
+}
+
+static bool matches(const std::optional<std::pair<const int8_t*, size_t>>& restored, const State& expected) {
+    return restored.has_value() &&
+        restored->second == expected.size() &&
+        memcmp(restored->first, expected.data(), expected.size()) == 0;
+}
+
+static void testRoundTrip() {
+    const size_t stateSize = 1003;
+    auto history = buildHistory(stateSize, 40);
+
+    RewindBuffer buffer(stateSize, RewindBuffer::Config { 1024 * 1024, 1 });
+    check(!buffer.rewind(1).has_value(), "empty buffer has nothing to rewind");
+
+    for (const auto& state : history) {
+        push(buffer, state);
+    }
+    check(buffer.getAvailableFrames() == history.size() - 1, "all deltas fit in the budget");
+
+    for (size_t i = history.size() - 1; i > 0; i--) {
+        check(matches(buffer.rewind(1), history[i - 1]), "rewind restores the previous state");
+    }
+
+    check(buffer.getAvailableFrames() == 0, "history is exhausted");
+    check(matches(buffer.rewind(1), history[0]), "exhausted history keeps the oldest state");
+}
+
+static void testFrameInterval() {
+    const size_t stateSize = 256;
+    auto history = buildHistory(stateSize, 10);
+
+    RewindBuffer buffer(stateSize, RewindBuffer::Config { 1024 * 1024, 3 });
+
+    int snapshots = 0;
+    for (int frame = 0; frame < 30; frame++) {
+        if (buffer.advanceFrame()) snapshots++;
+    }
+    check(snapshots == 10, "one snapshot every three frames");
+
+    for (const auto& state : history) {
+        push(buffer, state);
+    }
+    check(buffer.getAvailableFrames() == 27, "available frames account for the interval");
+
+    check(matches(buffer.rewind(4), history[7]), "frames are rounded up to whole snapshots");
+    check(matches(buffer.rewind(1), history[6]), "a single frame rewinds one snapshot");
+}
+
+static void testBudgetEvictsOldest() {
+    const size_t stateSize = 4096;
+    auto history = buildHistory(stateSize, 64);
+
+    // Fully rewritten states produce deltas as large as the state, so only a few fit.
+    RewindBuffer buffer(stateSize, RewindBuffer::Config { 6 * stateSize, 1 });
+    for (const auto& state : history) {
+        push(buffer, state);
+    }
+
+    unsigned available = buffer.getAvailableFrames();
+    check(available > 0 && available < history.size() - 1, "old entries are evicted");
+
+    size_t current = history.size() - 1;
+    for (unsigned i = 0; i < available; i++) {
+        current--;
+        check(matches(buffer.rewind(1), history[current]), "surviving entries are still valid");
+    }
+}
+
+static void testOversizedDeltaClearsHistory() {
+    const size_t stateSize = 4096;
+    auto history = buildHistory(stateSize, 4);
+
+    RewindBuffer buffer(stateSize, RewindBuffer::Config { 1024, 1 });
+    for (const auto& state : history) {
+        push(buffer, state);
+    }
+
+    check(buffer.getAvailableFrames() == 0, "deltas larger than the budget clear the history");
+    check(matches(buffer.rewind(1), history.back()), "the newest state is still available");
+}
+
+static void testReset() {
+    auto history = buildHistory(512, 8);
+
+    RewindBuffer buffer(512, RewindBuffer::Config { 1024 * 1024, 1 });
+    for (const auto& state : history) {
+        push(buffer, state);
+    }
+
+    buffer.reset(1000);
+    check(buffer.getStateSize() == 1000, "reset changes the state size");
+    check(buffer.getAvailableFrames() == 0, "reset clears the history");
+    check(!buffer.rewind(1).has_value(), "reset drops the current state");
+}
+
+} //namespace libretrodroid
+
+int main() {
+    using namespace libretrodroid;
+
+    testRoundTrip();
+    testFrameInterval();
+    testBudgetEvictsOldest();
+    testOversizedDeltaClearsHistory();
+    testReset();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Checks the bounds of SPSCQueue on a single thread, then streams values between two threads and
+// verifies that none is lost, duplicated or reordered.
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "utils/spscqueue.h"
+
+namespace libretrodroid {
+
+static int failures = 0;
+
+static void check(bool condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", message);
+        failures++;
+    }
+}
+
+static void testCapacity() {
+    SPSCQueue<int, 4> queue;
+    int value = 0;
+
+    check(queue.empty(), "new queue is empty");
+    check(!queue.pop(value), "empty queue has nothing to pop");
+
+    for (int i = 0; i < 4; i++) {
+        check(queue.push(int(i)), "push within capacity");
+    }
+
+    int rejected = 42;
+    check(!queue.push(std::move(rejected)), "full queue rejects elements");
+    check(rejected == 42, "rejected element is left untouched");
+
+    for (int i = 0; i < 4; i++) {
+        check(queue.pop(value) && value == i, "elements are popped in order");
+    }
+    check(queue.empty(), "drained queue is empty");
+}
+
+static void testWrapAround() {
+    SPSCQueue<std::string, 8> queue;
+    std::string value;
+
+    bool ordered = true;
+    for (int i = 0; i < 100; i++) {
+        ordered = ordered && queue.push(std::to_string(i)) && queue.push(std::to_string(i + 1000));
+        ordered = ordered && queue.pop(value) && value == std::to_string(i);
+        ordered = ordered && queue.pop(value) && value == std::to_string(i + 1000);
+    }
+    check(ordered, "indices wrap around the capacity");
+}
+
+static void testMoveOnlyElements() {
+    SPSCQueue<std::unique_ptr<int>, 2> queue;
+    std::unique_ptr<int> value;
+
+    check(queue.push(std::make_unique<int>(7)), "push move only element");
+    check(queue.pop(value) && value && *value == 7, "pop move only element");
+}
+
+static void testConcurrentTransfer() {
+    constexpr uint64_t COUNT = 1000000;
+    SPSCQueue<uint64_t, 64> queue;
+
+    std::thread producer([&queue]() {
+        for (uint64_t i = 0; i < COUNT;) {
+            if (queue.push(uint64_t(i))) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < COUNT) {
+        uint64_t value;
+        if (queue.pop(value)) {
+            ordered = ordered && value == expected;
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+    check(ordered, "values cross threads in order");
+    check(queue.empty(), "queue is empty after the transfer");
+}
+
+} //namespace libretrodroid
+
+int main() {
+    using namespace libretrodroid;
+
+    testCapacity();
+    testWrapAround();
+    testMoveOnlyElements();
+    testConcurrentTransfer();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Writes state containers into temporary files, then checks that they read back unchanged and
+// that damaged headers and blocks are rejected instead of producing a broken state.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+#include "statecontainer.h"
+
+namespace libretrodroid {
+
+static int failures = 0;
+
+static void check(bool condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", message);
+        failures++;
+    }
+}
+
+// Byte offset of the first block for the header built by makeHeader(), without thumbnail.
+static constexpr size_t FIRST_BLOCK_OFFSET = 4 + 2 + 2 + 4 + (4 + 8) + (4 + 5) + 8 + 4 + 4;
+static constexpr size_t BLOCK_HEADER_SIZE = 12;
+
+static StateContainer::Header makeHeader(uint64_t stateSize) {
+    StateContainer::Header result;
+    result.apiVersion = 1;
+    result.coreName = "testcore";
+    result.coreVersion = "1.0.0";
+    result.stateSize = stateSize;
+    result.romCrc = 0xCAFEBABE;
+    return result;
+}
+
+// The first block compresses well, the following ones are random and are stored as they are.
+static std::vector<int8_t> makeState(size_t size) {
+    std::mt19937 random(42);
+    std::vector<int8_t> result(size);
+    for (size_t i = 0; i < size; i++) {
+        result[i] = i < StateContainer::BLOCK_SIZE ? (int8_t) (i / 1024) : (int8_t) random();
+    }
+    return result;
+}
+
+static std::vector<uint8_t> readFile(int fd) {
+    std::vector<uint8_t> result(lseek(fd, 0, SEEK_END));
+    check(pread(fd, result.data(), result.size(), 0) == (ssize_t) result.size(), "read file back");
+    return result;
+}
+
+// Returns a file descriptor positioned at the beginning of the given content.
+static int writeFile(const std::vector<uint8_t>& content) {
+    FILE* file = tmpfile();
+    int fd = dup(fileno(file));
+    fclose(file);
+
+    check(write(fd, content.data(), content.size()) == (ssize_t) content.size(), "write file");
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+static std::vector<uint8_t> writeContainer(const std::vector<int8_t>& state, const StateContainer::Thumbnail* thumbnail) {
+    int fd = writeFile({});
+    check(StateContainer::write(fd, makeHeader(state.size()), state.data(), thumbnail), "write container");
+
+    auto result = readFile(fd);
+    close(fd);
+    return result;
+}
+
+static bool readsBack(const std::vector<uint8_t>& container, const std::vector<int8_t>& expected) {
+    int fd = writeFile(container);
+    StateContainer::Reader reader(fd);
+
+    std::vector<int8_t> state(expected.size());
+    bool result = reader.readHeader() && reader.readState(state.data(), state.size()) && state == expected;
+
+    close(fd);
+    return result;
+}
+
+static void testRoundTrip() {
+    auto state = makeState(StateContainer::BLOCK_SIZE * 2 + 1234);
+
+    StateContainer::Thumbnail thumbnail { 16, 8, std::vector<uint8_t>(16 * 8 * 4, 0x7F) };
+    auto container = writeContainer(state, &thumbnail);
+
+    int fd = writeFile(container);
+    StateContainer::Reader reader(fd);
+    check(reader.readHeader(), "header is valid");
+
+    const auto& header = reader.getHeader();
+    check(header.coreName == "testcore" && header.coreVersion == "1.0.0", "core is preserved");
+    check(header.apiVersion == 1 && header.romCrc == 0xCAFEBABE, "identity is preserved");
+    check(header.stateSize == state.size(), "state size is preserved");
+
+    auto readThumbnail = reader.readThumbnail();
+    check(readThumbnail.has_value(), "thumbnail is present");
+    check(readThumbnail.has_value() && readThumbnail->pixels == thumbnail.pixels, "thumbnail is preserved");
+
+    std::vector<int8_t> result(state.size());
+    check(reader.readState(result.data(), result.size()) && result == state, "state is preserved");
+    close(fd);
+
+    check(readsBack(container, state), "thumbnail is skipped when not read");
+    check(container.size() < state.size(), "compressible blocks are compressed");
+}
+
+static void testWrongSizeIsRejected() {
+    auto state = makeState(4096);
+    int fd = writeFile(writeContainer(state, nullptr));
+
+    StateContainer::Reader reader(fd);
+    std::vector<int8_t> result(state.size() + 1);
+    check(reader.readHeader(), "header is valid");
+    check(!reader.readState(result.data(), result.size()), "buffer of a different size is rejected");
+    close(fd);
+}
+
+static void testCorruptedHeaderIsRejected() {
+    auto state = makeState(4096);
+    auto container = writeContainer(state, nullptr);
+
+    auto wrongMagic = container;
+    wrongMagic[0] = 'X';
+    int fd = writeFile(wrongMagic);
+    check(!StateContainer::Reader(fd).readHeader(), "wrong magic is rejected");
+    close(fd);
+
+    auto newerVersion = container;
+    newerVersion[4] = StateContainer::VERSION + 1;
+    fd = writeFile(newerVersion);
+    check(!StateContainer::Reader(fd).readHeader(), "newer version is rejected");
+    close(fd);
+
+    auto truncated = std::vector<uint8_t>(container.begin(), container.begin() + 20);
+    fd = writeFile(truncated);
+    check(!StateContainer::Reader(fd).readHeader(), "truncated header is rejected");
+    close(fd);
+}
+
+static void testCorruptedBlocksAreRejected() {
+    auto state = makeState(StateContainer::BLOCK_SIZE + 4096);
+    auto container = writeContainer(state, nullptr);
+    check(readsBack(container, state), "untouched container is valid");
+
+    uint32_t firstBlock[3];
+    memcpy(firstBlock, container.data() + FIRST_BLOCK_OFFSET, sizeof(firstBlock));
+    check(firstBlock[0] < firstBlock[1], "first block is compressed");
+
+    size_t secondBlockOffset = FIRST_BLOCK_OFFSET + BLOCK_HEADER_SIZE + firstBlock[0];
+    uint32_t secondBlock[3];
+    memcpy(secondBlock, container.data() + secondBlockOffset, sizeof(secondBlock));
+    check(secondBlock[0] == secondBlock[1], "random block is stored");
+
+    auto wrongChecksum = container;
+    wrongChecksum[FIRST_BLOCK_OFFSET + 8] ^= 0x01;
+    check(!readsBack(wrongChecksum, state), "checksum mismatch is rejected");
+
+    auto corruptedCompressed = container;
+    corruptedCompressed[FIRST_BLOCK_OFFSET + BLOCK_HEADER_SIZE + firstBlock[0] / 2] ^= 0xFF;
+    check(!readsBack(corruptedCompressed, state), "corrupted compressed data is rejected");
+
+    auto corruptedStored = container;
+    corruptedStored[secondBlockOffset + BLOCK_HEADER_SIZE + 100] ^= 0x01;
+    check(!readsBack(corruptedStored, state), "corrupted stored data is rejected");
+
+    auto wrongRawSize = container;
+    wrongRawSize[FIRST_BLOCK_OFFSET + 4] ^= 0x01;
+    check(!readsBack(wrongRawSize, state), "unexpected block size is rejected");
+
+    auto truncated = std::vector<uint8_t>(container.begin(), container.end() - 10);
+    check(!readsBack(truncated, state), "truncated state is rejected");
+}
+
+} //namespace libretrodroid
+
+int main() {
+    using namespace libretrodroid;
+
+    testRoundTrip();
+    testWrongSizeIsRejected();
+    testCorruptedHeaderIsRejected();
+    testCorruptedBlocksAreRejected();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
@@ -178,41 +178,48 @@ int Input::convertAndroidToLibretroKey(int keyCode) const {
     }
 }
 
-void Input::onKeyEvent(unsigned int port, int action, int keyCode) {
+bool Input::onKeyEvent(unsigned int port, int action, int keyCode) {
     int retroKeyCode = convertAndroidToLibretroKey(keyCode);
     if (retroKeyCode == UNKNOWN_KEY) {
-        return;
+        return false;
     }
 
     if (action == AKEY_EVENT_ACTION_DOWN) {
-        pads[port].pressedKeys.insert(retroKeyCode);
+        return pads[port].pressedKeys.insert(retroKeyCode).second;
     } else if (action == AKEY_EVENT_ACTION_UP) {
-        pads[port].pressedKeys.erase(retroKeyCode);
+        return pads[port].pressedKeys.erase(retroKeyCode) > 0;
     }
+
+    return false;
 }
 
-void Input::onMotionEvent(int port, int motionSource, float xAxis, float yAxis) {
+bool Input::onMotionEvent(int port, int motionSource, float xAxis, float yAxis) {
     switch (motionSource) {
         case Input::MOTION_SOURCE_DPAD:
-            pads[port].dpadXAxis = (int) round(xAxis);
-            pads[port].dpadYAxis = (int) round(yAxis);
-            break;
+            return updateAxes(pads[port].dpadXAxis, pads[port].dpadYAxis, (int) round(xAxis), (int) round(yAxis));
 
         case Input::MOTION_SOURCE_ANALOG_LEFT:
-            pads[port].joypadLeftXAxis = xAxis;
-            pads[port].joypadLeftYAxis = yAxis;
-            break;
+            return updateAxes(pads[port].joypadLeftXAxis, pads[port].joypadLeftYAxis, xAxis, yAxis);
 
         case Input::MOTION_SOURCE_ANALOG_RIGHT:
-            pads[port].joypadRightXAxis = xAxis;
-            pads[port].joypadRightYAxis = yAxis;
-            break;
+            return updateAxes(pads[port].joypadRightXAxis, pads[port].joypadRightYAxis, xAxis, yAxis);
 
         case Input::MOTION_SOURCE_POINTER:
-            pads[port].pointerScreenXAxis = xAxis;
-            pads[port].pointerScreenYAxis = yAxis;
-            break;
+            return updateAxes(pads[port].pointerScreenXAxis, pads[port].pointerScreenYAxis, xAxis, yAxis);
+    }
+
+    return false;
+}
+
+template<typename T>
+bool Input::updateAxes(T& xAxis, T& yAxis, T newXAxis, T newYAxis) {
+    if (xAxis == newXAxis && yAxis == newYAxis) {
+        return false;
     }
+
+    xAxis = newXAxis;
+    yAxis = newYAxis;
+    return true;
 }
 
 template<typename... T>
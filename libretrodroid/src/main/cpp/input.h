@@ -54,8 +54,9 @@ public:
 
     int16_t getInputState(unsigned port, unsigned device, unsigned index, unsigned id);
 
-    void onKeyEvent(unsigned int port, int action, int keyCode);
-    void onMotionEvent(int port, int motionSource, float xAxis, float yAxis);
+    // Both return true if the event changed the state of the pad.
+    bool onKeyEvent(unsigned int port, int action, int keyCode);
+    bool onMotionEvent(int port, int motionSource, float xAxis, float yAxis);
 
 private:
     const int UNKNOWN_KEY = -1;
@@ -65,6 +66,9 @@ private:
     bool anyPressed(unsigned int port, unsigned int id) const;
     int convertAndroidToLibretroKey(int keyCode) const;
 
+    template<typename T>
+    static bool updateAxes(T& xAxis, T& yAxis, T newXAxis, T newYAxis);
+
     GamePadState pads[4];
 };
 
@@ -0,0 +1,149 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "inputlatencytracer.h"
+
+#include <algorithm>
+#include <ctime>
+#include <vector>
+
+namespace libretrodroid {
+
+int64_t InputLatencyTracer::now() {
+    struct timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+void InputLatencyTracer::setEnabled(bool value) {
+    if (value && !isEnabled()) {
+        reset();
+    }
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+void InputLatencyTracer::onEvent(unsigned port, int64_t eventTime) {
+    if (!isEnabled()) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingEvents.size() >= MAX_PENDING_EVENTS) {
+        pendingEvents.pop_front();
+    }
+    pendingEvents.push_back(PendingEvent { port, eventTime, 0, 0, getCurrentFrame() });
+    hasUnreadEvents.store(true, std::memory_order_release);
+}
+
+void InputLatencyTracer::onInputRead(unsigned port) {
+    // Cores query the input many times per frame, this keeps the common case lock free.
+    if (!hasUnreadEvents.load(std::memory_order_acquire)) return;
+
+    int64_t readTime = now();
+    uint64_t frame = getCurrentFrame();
+    bool unreadEvents = false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& event : pendingEvents) {
+        if (event.readTime != 0) continue;
+
+        if (event.port == port) {
+            event.readTime = readTime;
+            event.frame = frame;
+            record(readLatencies, readTime - event.eventTime);
+        } else {
+            unreadEvents = true;
+        }
+    }
+    hasUnreadEvents.store(unreadEvents, std::memory_order_release);
+}
+
+uint64_t InputLatencyTracer::getCurrentFrame() const {
+    return currentFrame.load(std::memory_order_acquire);
+}
+
+void InputLatencyTracer::onFrameCompleted() {
+    uint64_t frame = currentFrame.fetch_add(1, std::memory_order_acq_rel) + 1;
+    if (!hasUnreadEvents.load(std::memory_order_acquire)) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bool unreadEvents = false;
+    auto iterator = pendingEvents.begin();
+    while (iterator != pendingEvents.end()) {
+        if (iterator->readTime != 0) {
+            ++iterator;
+        } else if (iterator->eventFrame + UNREAD_EVENT_FRAMES <= frame) {
+            iterator = pendingEvents.erase(iterator);
+        } else {
+            unreadEvents = true;
+            ++iterator;
+        }
+    }
+    hasUnreadEvents.store(unreadEvents, std::memory_order_release);
+}
+
+void InputLatencyTracer::onFramePresented(uint64_t frame) {
+    if (!isEnabled()) return;
+
+    int64_t presentTime = now();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iterator = pendingEvents.begin();
+    while (iterator != pendingEvents.end()) {
+        if (iterator->readTime != 0 && iterator->frame <= frame) {
+            record(presentLatencies, presentTime - iterator->eventTime);
+            iterator = pendingEvents.erase(iterator);
+        } else {
+            ++iterator;
+        }
+    }
+}
+
+void InputLatencyTracer::record(Ring& ring, int64_t nanos) {
+    ring.samples[ring.count % RING_SIZE] = (uint32_t) std::max<int64_t>(nanos / 1000, 0);
+    ring.count++;
+}
+
+InputLatencyTracer::Distribution InputLatencyTracer::computeDistribution(const Ring& ring) {
+    size_t samples = std::min(ring.count, RING_SIZE);
+    if (samples == 0) return Distribution {};
+
+    std::vector<uint32_t> values(ring.samples.begin(), ring.samples.begin() + samples);
+    std::sort(values.begin(), values.end());
+
+    return Distribution {
+        (uint32_t) samples,
+        values.front(),
+        values[(samples - 1) * 50 / 100],
+        values[(samples - 1) * 95 / 100],
+        values.back()
+    };
+}
+
+InputLatencyTracer::Stats InputLatencyTracer::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return Stats { computeDistribution(readLatencies), computeDistribution(presentLatencies) };
+}
+
+void InputLatencyTracer::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingEvents.clear();
+    readLatencies = Ring {};
+    presentLatencies = Ring {};
+    hasUnreadEvents.store(false, std::memory_order_release);
+}
+
+} //namespace libretrodroid
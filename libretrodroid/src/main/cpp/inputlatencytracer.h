@@ -0,0 +1,104 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_INPUTLATENCYTRACER_H
+#define LIBRETRODROID_INPUTLATENCYTRACER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace libretrodroid {
+
+// Follows input events from the Android timestamp to the first time the core reads the port they
+// changed and to the presentation of the frame which consumed them. Timestamps are CLOCK_MONOTONIC
+// nanoseconds, which is the clock of System.nanoTime() and of the event times.
+class InputLatencyTracer {
+public:
+    struct Distribution {
+        uint32_t samples = 0;
+        uint32_t min = 0;
+        uint32_t p50 = 0;
+        uint32_t p95 = 0;
+        uint32_t max = 0;
+    };
+
+    // Latencies in microseconds, from the event to the core reading it and to the frame showing it.
+    struct Stats {
+        Distribution toRead;
+        Distribution toPresent;
+    };
+
+    static int64_t now();
+
+    bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool value);
+
+    void onEvent(unsigned port, int64_t eventTime);
+    void onInputRead(unsigned port);
+
+    // The frames produced by the core are numbered, an event belongs to the frame running when
+    // the core read it.
+    uint64_t getCurrentFrame() const;
+    void onFrameCompleted();
+    void onFramePresented(uint64_t frame);
+
+    Stats getStats();
+    void reset();
+
+private:
+    static constexpr size_t RING_SIZE = 256;
+    static constexpr size_t MAX_PENDING_EVENTS = 64;
+
+    // Events on ports which the core does not poll are dropped after a few frames.
+    static constexpr uint64_t UNREAD_EVENT_FRAMES = 2;
+
+    struct PendingEvent {
+        unsigned port;
+        int64_t eventTime;
+        int64_t readTime;
+        uint64_t frame;
+        uint64_t eventFrame;
+    };
+
+    struct Ring {
+        std::array<uint32_t, RING_SIZE> samples {};
+        size_t count = 0;
+    };
+
+    static void record(Ring& ring, int64_t nanos);
+    static Distribution computeDistribution(const Ring& ring);
+
+    std::atomic<bool> enabled { false };
+    std::atomic<bool> hasUnreadEvents { false };
+    std::atomic<uint64_t> currentFrame { 1 };
+
+    std::mutex mutex;
+    std::deque<PendingEvent> pendingEvents;
+    Ring readLatencies;
+    Ring presentLatencies;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_INPUTLATENCYTRACER_H
@@ -0,0 +1,352 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "inputmovie.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#include "log.h"
+#include "utils/utils.h"
+
+namespace libretrodroid {
+
+static const char MOVIE_MAGIC[4] = { 'L', 'R', 'M', 'V' };
+
+static constexpr uint32_t MAX_STRING_LENGTH = 1024;
+
+// Android only runs on little endian architectures, so values are copied as they are.
+template <typename T>
+static void append(std::vector<uint8_t>& output, T value) {
+    size_t offset = output.size();
+    output.resize(offset + sizeof(T));
+    memcpy(output.data() + offset, &value, sizeof(T));
+}
+
+static void appendString(std::vector<uint8_t>& output, const std::string& value) {
+    append<uint32_t>(output, (uint32_t) value.size());
+    output.insert(output.end(), value.begin(), value.end());
+}
+
+uint32_t InputMovie::makeKey(unsigned port, unsigned device, unsigned index, unsigned id) {
+    return ((port & 0xF) << 28) | ((index & 0xF) << 24) | ((id & 0xFFF) << 12) | (device & 0xFFF);
+}
+
+std::unique_ptr<InputMovieRecorder> InputMovieRecorder::create(
+    int fd,
+    const InputMovie::Header& header,
+    const int8_t* state,
+    size_t stateSize
+) {
+    std::vector<uint8_t> output;
+    output.insert(output.end(), MOVIE_MAGIC, MOVIE_MAGIC + sizeof(MOVIE_MAGIC));
+    append<uint16_t>(output, InputMovie::VERSION);
+    append<uint16_t>(output, 0);
+    appendString(output, header.coreName);
+    appendString(output, header.coreVersion);
+    append<uint32_t>(output, header.romCrc);
+    append<uint64_t>(output, stateSize);
+
+    // The starting state is written once, before recording begins.
+    bool result = Utils::writeFully(fd, output.data(), output.size()) &&
+        Utils::writeFully(fd, state, stateSize);
+
+    if (!result) {
+        LOGE("Cannot write input movie header: %s", strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+
+    return std::unique_ptr<InputMovieRecorder>(new InputMovieRecorder(fd));
+}
+
+InputMovieRecorder::InputMovieRecorder(int fd) : fd(fd) {
+    for (auto& block : blocks) {
+        block.data.resize(BLOCK_SIZE);
+        freeBlocks.push_back(&block);
+    }
+
+    currentBlock = freeBlocks.back();
+    freeBlocks.pop_back();
+
+    worker = std::thread([this]() { run(); });
+}
+
+InputMovieRecorder::~InputMovieRecorder() {
+    finish();
+}
+
+void InputMovieRecorder::record(unsigned port, unsigned device, unsigned index, unsigned id, int16_t value) {
+    if (recordCount >= records.size()) {
+        if (!overflowLogged) {
+            LOGW("Too many input queries in a single frame, the movie will not replay correctly");
+            overflowLogged = true;
+        }
+        return;
+    }
+
+    records[recordCount++] = InputMovie::Record { InputMovie::makeKey(port, device, index, id), value };
+}
+
+void InputMovieRecorder::endFrame() {
+    bool repeat = hasPreviousFrame && recordCount == previousRecordCount && std::equal(
+        records.begin(),
+        records.begin() + recordCount,
+        previousRecords.begin(),
+        [](const InputMovie::Record& first, const InputMovie::Record& second) {
+            return first.key == second.key && first.value == second.value;
+        }
+    );
+
+    if (repeat) {
+        uint32_t marker = InputMovie::REPEAT_FRAME;
+        appendToBlock(&marker, sizeof(marker));
+    } else {
+        uint32_t count = (uint32_t) recordCount;
+        appendToBlock(&count, sizeof(count));
+
+        for (size_t i = 0; i < recordCount; i++) {
+            appendToBlock(&records[i].key, sizeof(records[i].key));
+            appendToBlock(&records[i].value, sizeof(records[i].value));
+        }
+
+        std::copy_n(records.begin(), recordCount, previousRecords.begin());
+        previousRecordCount = recordCount;
+        hasPreviousFrame = true;
+    }
+
+    recordCount = 0;
+}
+
+void InputMovieRecorder::appendToBlock(const void* data, size_t size) {
+    if (currentBlock->size + size > currentBlock->data.size()) {
+        submitBlock();
+    }
+
+    memcpy(currentBlock->data.data() + currentBlock->size, data, size);
+    currentBlock->size += size;
+}
+
+// Only waits if the worker is so far behind that every pooled block is pending.
+void InputMovieRecorder::submitBlock() {
+    std::unique_lock<std::mutex> lock(mutex);
+    filledBlocks.push_back(currentBlock);
+    condition.notify_all();
+
+    condition.wait(lock, [this]() { return !freeBlocks.empty(); });
+    currentBlock = freeBlocks.back();
+    freeBlocks.pop_back();
+}
+
+void InputMovieRecorder::run() {
+    while (true) {
+        Block* block;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopped || !filledBlocks.empty(); });
+
+            if (filledBlocks.empty()) return;
+
+            block = filledBlocks.front();
+            filledBlocks.pop_front();
+        }
+
+        bool result = Utils::writeFully(fd, block->data.data(), block->size);
+        if (!result) {
+            LOGE("Error while writing input movie: %s", strerror(errno));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = failed || !result;
+            block->size = 0;
+            freeBlocks.push_back(block);
+        }
+        condition.notify_all();
+    }
+}
+
+bool InputMovieRecorder::finish() {
+    if (finished) return !failed;
+    finished = true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (currentBlock->size > 0) {
+            filledBlocks.push_back(currentBlock);
+        }
+        stopped = true;
+    }
+    condition.notify_all();
+    worker.join();
+
+    bool result = !failed && fsync(fd) == 0;
+    if (close(fd) != 0) {
+        result = false;
+    }
+
+    return result;
+}
+
+std::unique_ptr<InputMoviePlayer> InputMoviePlayer::create(int fd) {
+    auto result = std::unique_ptr<InputMoviePlayer>(new InputMoviePlayer());
+
+    result->file = MappedFile::open(fd);
+    if (!result->file || !result->parseHeader()) {
+        LOGE("Invalid input movie");
+        return nullptr;
+    }
+
+    return result;
+}
+
+bool InputMoviePlayer::parseHeader() {
+    auto data = static_cast<const uint8_t*>(file->getData());
+    size_t size = file->getSize();
+
+    auto read = [&](void* value, size_t length) {
+        if (length > size - offset) return false;
+        memcpy(value, data + offset, length);
+        offset += length;
+        return true;
+    };
+
+    auto readString = [&](std::string& value) {
+        uint32_t length;
+        if (!read(&length, sizeof(length)) || length > MAX_STRING_LENGTH) return false;
+        value.resize(length);
+        return read(value.data(), length);
+    };
+
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint64_t movieStateSize;
+
+    bool result = read(magic, sizeof(magic)) &&
+        memcmp(magic, MOVIE_MAGIC, sizeof(magic)) == 0 &&
+        read(&version, sizeof(version)) &&
+        version <= InputMovie::VERSION &&
+        read(&flags, sizeof(flags)) &&
+        readString(header.coreName) &&
+        readString(header.coreVersion) &&
+        read(&header.romCrc, sizeof(header.romCrc)) &&
+        read(&movieStateSize, sizeof(movieStateSize)) &&
+        movieStateSize <= size - offset;
+
+    if (!result) return false;
+
+    state = reinterpret_cast<const int8_t*>(data + offset);
+    stateSize = (size_t) movieStateSize;
+    offset += stateSize;
+    return true;
+}
+
+const InputMovie::Header& InputMoviePlayer::getHeader() const {
+    return header;
+}
+
+const int8_t* InputMoviePlayer::getState() const {
+    return state;
+}
+
+size_t InputMoviePlayer::getStateSize() const {
+    return stateSize;
+}
+
+bool InputMoviePlayer::beginFrame() {
+    auto data = static_cast<const uint8_t*>(file->getData());
+    size_t size = file->getSize();
+
+    uint32_t count;
+    if (sizeof(count) > size - offset) {
+        hasFrame = false;
+        return false;
+    }
+    memcpy(&count, data + offset, sizeof(count));
+
+    if (count == InputMovie::REPEAT_FRAME) {
+        if (!hasFrame) return false;
+        offset += sizeof(count);
+    } else {
+        size_t frameSize = (size_t) count * InputMovie::RECORD_SIZE;
+        if (count > InputMovie::MAX_RECORDS_PER_FRAME || frameSize > size - offset - sizeof(count)) {
+            LOGE("Truncated input movie after %llu frames", (unsigned long long) frames);
+            hasFrame = false;
+            return false;
+        }
+
+        offset += sizeof(count);
+        frameOffset = offset;
+        frameRecords = count;
+        offset += frameSize;
+    }
+
+    nextRecord = 0;
+    hasFrame = true;
+    frames++;
+    return true;
+}
+
+InputMovie::Record InputMoviePlayer::readRecord(size_t index) const {
+    auto data = static_cast<const uint8_t*>(file->getData()) + frameOffset + index * InputMovie::RECORD_SIZE;
+
+    InputMovie::Record result {};
+    memcpy(&result.key, data, sizeof(result.key));
+    memcpy(&result.value, data + sizeof(result.key), sizeof(result.value));
+    return result;
+}
+
+// A deterministic core asks for the same inputs in the same order, so the next record is the
+// expected one. Otherwise we look for the key in the whole frame and count the mismatch.
+int16_t InputMoviePlayer::getInputState(unsigned port, unsigned device, unsigned index, unsigned id) {
+    if (!hasFrame) return 0;
+
+    uint32_t key = InputMovie::makeKey(port, device, index, id);
+
+    if (nextRecord < frameRecords) {
+        auto record = readRecord(nextRecord);
+        if (record.key == key) {
+            nextRecord++;
+            return record.value;
+        }
+    }
+
+    mismatches++;
+
+    for (size_t i = 0; i < frameRecords; i++) {
+        auto record = readRecord(i);
+        if (record.key == key) {
+            return record.value;
+        }
+    }
+
+    return 0;
+}
+
+uint64_t InputMoviePlayer::getFrames() const {
+    return frames;
+}
+
+uint64_t InputMoviePlayer::getMismatches() const {
+    return mismatches;
+}
+
+} //namespace libretrodroid
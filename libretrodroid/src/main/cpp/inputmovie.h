@@ -0,0 +1,165 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_INPUTMOVIE_H
+#define LIBRETRODROID_INPUTMOVIE_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/mappedfile.h"
+
+namespace libretrodroid {
+
+// Input movies store the answers of every input_state call, frame by frame, together with the
+// state the recording started from. Replaying them on the same core and game is frame exact.
+//
+// Layout: "LRMV", u16 version, u16 flags, core name, core version, u32 rom crc, u64 state size,
+// state, then one entry per frame. An entry is a u32 record count followed by the records, each a
+// u32 key and an i16 value. REPEAT_FRAME instead of the count repeats the previous frame.
+class InputMovie {
+public:
+    struct Header {
+        std::string coreName;
+        std::string coreVersion;
+        uint32_t romCrc = 0;
+    };
+
+    struct Record {
+        uint32_t key;
+        int16_t value;
+    };
+
+    static uint32_t makeKey(unsigned port, unsigned device, unsigned index, unsigned id);
+
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint32_t REPEAT_FRAME = 0xFFFFFFFF;
+    static constexpr size_t MAX_RECORDS_PER_FRAME = 1024;
+    static constexpr size_t RECORD_SIZE = sizeof(uint32_t) + sizeof(int16_t);
+};
+
+// Frames are encoded into pooled blocks which are written by a background thread, so recording
+// never allocates nor touches the disk while the core is running.
+class InputMovieRecorder {
+public:
+    // Takes ownership of the file descriptor. Returns nullptr if the header cannot be written.
+    static std::unique_ptr<InputMovieRecorder> create(
+        int fd,
+        const InputMovie::Header& header,
+        const int8_t* state,
+        size_t stateSize
+    );
+
+    ~InputMovieRecorder();
+
+    InputMovieRecorder(InputMovieRecorder const&) = delete;
+    void operator=(InputMovieRecorder const&) = delete;
+
+    void record(unsigned port, unsigned device, unsigned index, unsigned id, int16_t value);
+    void endFrame();
+
+    // Flushes the pending frames and closes the file. Returns false if any write failed.
+    bool finish();
+
+private:
+    explicit InputMovieRecorder(int fd);
+
+    struct Block {
+        std::vector<uint8_t> data;
+        size_t size = 0;
+    };
+
+    void appendToBlock(const void* data, size_t size);
+    void submitBlock();
+    void run();
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t POOLED_BLOCKS = 4;
+
+    int fd;
+
+    std::array<InputMovie::Record, InputMovie::MAX_RECORDS_PER_FRAME> records;
+    std::array<InputMovie::Record, InputMovie::MAX_RECORDS_PER_FRAME> previousRecords;
+    size_t recordCount = 0;
+    size_t previousRecordCount = 0;
+    bool hasPreviousFrame = false;
+    bool overflowLogged = false;
+
+    std::array<Block, POOLED_BLOCKS> blocks;
+    Block* currentBlock = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Block*> filledBlocks;
+    std::vector<Block*> freeBlocks;
+    bool stopped = false;
+    bool failed = false;
+    bool finished = false;
+
+    std::thread worker;
+};
+
+class InputMoviePlayer {
+public:
+    // Takes ownership of the file descriptor. Returns nullptr if the file is not a valid movie.
+    static std::unique_ptr<InputMoviePlayer> create(int fd);
+
+    const InputMovie::Header& getHeader() const;
+    const int8_t* getState() const;
+    size_t getStateSize() const;
+
+    // Returns false once all the recorded frames have been played.
+    bool beginFrame();
+    int16_t getInputState(unsigned port, unsigned device, unsigned index, unsigned id);
+
+    uint64_t getFrames() const;
+    uint64_t getMismatches() const;
+
+private:
+    InputMoviePlayer() = default;
+
+    bool parseHeader();
+    InputMovie::Record readRecord(size_t index) const;
+
+private:
+    std::unique_ptr<MappedFile> file;
+    InputMovie::Header header;
+    const int8_t* state = nullptr;
+    size_t stateSize = 0;
+
+    size_t offset = 0;
+    size_t frameOffset = 0;
+    size_t frameRecords = 0;
+    size_t nextRecord = 0;
+    bool hasFrame = false;
+
+    uint64_t frames = 0;
+    uint64_t mismatches = 0;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_INPUTMOVIE_H
@@ -21,8 +21,14 @@
 
 #include <string>
 #include <utility>
+#include <cerrno>
+#include <cstring>
 #include <vector>
 #include <unordered_set>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <zlib.h>
 
 #include "libretrodroid.h"
 #include "utils/libretrodroidexception.h"
@@ -44,6 +50,7 @@
 #include "utils/rect.h"
 #include "errorcodes.h"
 #include "vfs/vfs.h"
+#include "microphone/microphoneinterface.h"
 
 namespace libretrodroid {
 
@@ -83,8 +90,57 @@ int16_t LibretroDroid::callback_set_input_state(
 }
 
 void LibretroDroid::updateAudioSampleRateMultiplier() {
+    appliedFrameSpeed = getFrameSpeed();
     if (audio) {
-        audio->setPlaybackSpeed(frameSpeed);
+        audio->setPlaybackSpeed(appliedFrameSpeed);
+    }
+}
+
+// Cores can force fast forward on or off through RETRO_ENVIRONMENT_SET_FASTFORWARDING_OVERRIDE,
+// while inhibit_toggle keeps the user from fast forwarding.
+unsigned LibretroDroid::getFrameSpeed() const {
+    const auto& fastForwardingOverride = Environment::getInstance().getFastForwardingOverride();
+
+    if (fastForwardingOverride.fastforward) {
+        if (fastForwardingOverride.ratio > 0.0f) {
+            return std::max((unsigned) std::lround(fastForwardingOverride.ratio), 1u);
+        }
+        return frameSpeed > 1 ? frameSpeed : DEFAULT_FAST_FORWARD_SPEED;
+    }
+
+    return fastForwardingOverride.inhibit_toggle ? 1 : frameSpeed;
+}
+
+// The frame after a rewind is reported as rewinding, so cores can tell it apart from normal play.
+void LibretroDroid::updateThrottleState(unsigned speed) {
+    auto fps = (float) contentTiming.fps;
+
+    if (rewinding) {
+        rewinding = false;
+        Environment::getInstance().setThrottleState(RETRO_THROTTLE_REWINDING, fps);
+    } else if (speed > 1) {
+        Environment::getInstance().setThrottleState(RETRO_THROTTLE_FAST_FORWARD, fps * speed);
+    } else if (fpsSync && fpsSync->isUsingVSync()) {
+        Environment::getInstance().setThrottleState(RETRO_THROTTLE_VSYNC, screenRefreshRate);
+    } else {
+        Environment::getInstance().setThrottleState(RETRO_THROTTLE_NONE, fps);
+    }
+}
+
+void LibretroDroid::updateTiming(double fps, double sampleRate) {
+    if (fps <= 0.0 || sampleRate <= 0.0) return;
+    if (fps == contentTiming.fps && sampleRate == contentTiming.sampleRate) return;
+
+    contentTiming = { fps, sampleRate };
+
+    double timeStretchFactor = 1.0;
+    if (fpsSync) {
+        fpsSync->setContentRefreshRate(fps);
+        timeStretchFactor = fpsSync->getTimeStretchFactor(fps);
+    }
+
+    if (audio) {
+        audio->setInputSampleRate((int32_t) std::lround(sampleRate * timeStretchFactor), fps);
     }
 }
 
@@ -96,6 +152,20 @@ void LibretroDroid::resetGlobalVariables() {
     fpsSync = nullptr;
     input = nullptr;
     rumble = nullptr;
+    rewindBuffer = nullptr;
+    stateWriter = nullptr;
+    sramTracker = nullptr;
+    sramDirty = false;
+    warmStart = nullptr;
+    warmStartPending = false;
+    movieRecorder = nullptr;
+    moviePlayer = nullptr;
+    videoFrames = nullptr;
+    pendingMessages.clear();
+    {
+        std::lock_guard<std::mutex> updatesLock(frameUpdatesLock);
+        frameUpdates = FrameUpdates {};
+    }
 }
 
 int LibretroDroid::availableDisks() {
@@ -144,17 +214,42 @@ void LibretroDroid::setControllerType(unsigned int port, unsigned int type) {
     core->retro_set_controller_port_device(port, type);
 }
 
-bool LibretroDroid::unserializeState(int8_t *data, size_t size) {
+bool LibretroDroid::unserializeState(const int8_t* data, size_t size) {
     std::lock_guard<std::mutex> lock(coreLock);
 
+    if (isMovieActive()) {
+        LOGE("Cannot load state while an input movie is active");
+        return false;
+    }
+
     return core->retro_unserialize(data, size);
 }
 
-JNIEXPORT jboolean JNICALL LibretroDroid::unserializeSRAM(int8_t* data, size_t size) {
+bool LibretroDroid::unserializeState(size_t size, const std::function<void(int8_t*, size_t)>& producer) {
+    std::lock_guard<std::mutex> lock(coreLock);
+
+    if (isMovieActive()) {
+        LOGE("Cannot load state while an input movie is active");
+        return false;
+    }
+
+    serializeScratch.resize(size);
+    producer(serializeScratch.data(), size);
+
+    return core->retro_unserialize(serializeScratch.data(), size);
+}
+
+JNIEXPORT jboolean JNICALL LibretroDroid::unserializeSRAM(const int8_t* data, size_t size) {
+    return unserializeSRAM(size, [data](int8_t* sramState, size_t size) {
+        memcpy(sramState, data, size);
+    });
+}
+
+jboolean LibretroDroid::unserializeSRAM(size_t size, const std::function<void(int8_t*, size_t)>& producer) {
     std::lock_guard<std::mutex> lock(coreLock);
 
     size_t sramSize = core->retro_get_memory_size(RETRO_MEMORY_SAVE_RAM);
-    void *sramState = core->retro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
+    auto* sramState = (int8_t*) core->retro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
 
     if (sramState == nullptr) {
         LOGE("Cannot load SRAM: nullptr in retro_get_memory_data");
@@ -166,21 +261,93 @@ JNIEXPORT jboolean JNICALL LibretroDroid::unserializeSRAM(int8_t* data, size_t s
         return false;
     }
 
-    memcpy(sramState, data, size);
+    producer(sramState, size);
+
+    if (sramTracker) {
+        sramTracker->reset((const uint8_t*) sramState, sramSize);
+        sramDirty = false;
+    }
+
+    return true;
+}
+
+bool LibretroDroid::serializeSRAM(const std::function<void(const int8_t*, size_t)>& consumer) {
+    std::lock_guard<std::mutex> lock(coreLock);
+
+    auto [data, size] = getSRAMMemory();
+    if (data == nullptr) {
+        return false;
+    }
 
+    consumer(data, size);
     return true;
 }
 
-std::pair<int8_t*, size_t> LibretroDroid::serializeSRAM() {
+std::pair<int8_t*, size_t> LibretroDroid::getSRAMBuffer() {
     std::lock_guard<std::mutex> lock(coreLock);
+    if (!core) return std::pair(nullptr, 0);
+
+    return getSRAMMemory();
+}
 
+// Must be called while holding coreLock.
+std::pair<int8_t*, size_t> LibretroDroid::getSRAMMemory() {
     size_t size = core->retro_get_memory_size(RETRO_MEMORY_SAVE_RAM);
-    auto* data = new int8_t[size];
-    memcpy(data, (int8_t*) core->retro_get_memory_data(RETRO_MEMORY_SAVE_RAM), size);
+    auto* data = (int8_t*) core->retro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
+
+    if (data == nullptr || size == 0) {
+        return std::pair(nullptr, 0);
+    }
 
     return std::pair(data, size);
 }
 
+bool LibretroDroid::isSRAMDirty() {
+    return sramDirty;
+}
+
+// Only copying the changed pages happens under coreLock, writing and syncing them does not block
+// the emulation. Flushes are serialized, so that pages are never written out of order.
+bool LibretroDroid::flushSRAM(int fd) {
+    std::lock_guard<std::mutex> flushLock(sramFlushLock);
+
+    struct stat fileStat {};
+    size_t fileSize = fstat(fd, &fileStat) == 0 ? fileStat.st_size : 0;
+
+    SRAMTracker::DirtyPages dirtyPages;
+    {
+        std::lock_guard<std::mutex> lock(coreLock);
+
+        auto [data, size] = getSRAMMemory();
+        if (!sramTracker || data == nullptr) {
+            LOGE("Cannot flush SRAM: the core does not expose save memory");
+            return false;
+        }
+
+        dirtyPages = sramTracker->takeDirtyPages((const uint8_t*) data, size, fileSize);
+        sramDirty = false;
+    }
+
+    if (SRAMTracker::writePages(dirtyPages, fd)) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(coreLock);
+    if (sramTracker) {
+        sramTracker->invalidate();
+        sramDirty = true;
+    }
+    return false;
+}
+
+void LibretroDroid::updateSRAMTracker() {
+    auto [data, size] = getSRAMMemory();
+    if (data != nullptr) {
+        sramTracker->update((const uint8_t*) data, size);
+        sramDirty = sramTracker->isDirty();
+    }
+}
+
 void LibretroDroid::onSurfaceChanged(unsigned int width, unsigned int height) {
     LOGD("Performing libretrodroid onSurfaceChanged");
     video->updateScreenSize(width, height);
@@ -226,26 +393,37 @@ void LibretroDroid::onMotionEvent(
     unsigned int port,
     unsigned int source,
     float xAxis,
-    float yAxis
+    float yAxis,
+    int64_t eventTime
 ) {
     LOGD("Received motion event: %d %.2f, %.2f", source, xAxis, yAxis);
+    std::lock_guard<std::mutex> lock(inputLock);
     if (input) {
-        input->onMotionEvent(port, source, xAxis, yAxis);
+        // A single Android event is forwarded once per axis source, most of them do not change.
+        if (input->onMotionEvent(port, source, xAxis, yAxis)) {
+            inputLatencyTracer.onEvent(port, eventTime);
+        }
     }
 }
 
-void LibretroDroid::onTouchEvent(float xAxis, float yAxis) {
+void LibretroDroid::onTouchEvent(float xAxis, float yAxis, int64_t eventTime) {
     LOGD("Received touch event: %.2f, %.2f", xAxis, yAxis);
+    std::lock_guard<std::mutex> lock(inputLock);
     if (input && video) {
         auto [x, y] = video->getLayout().getRelativePosition(xAxis, yAxis);
-        input->onMotionEvent(0, Input::MOTION_SOURCE_POINTER, x, y);
+        if (input->onMotionEvent(0, Input::MOTION_SOURCE_POINTER, x, y)) {
+            inputLatencyTracer.onEvent(0, eventTime);
+        }
     }
 }
 
-void LibretroDroid::onKeyEvent(unsigned int port, int action, int keyCode) {
+void LibretroDroid::onKeyEvent(unsigned int port, int action, int keyCode, int64_t eventTime) {
     LOGD("Received key event with action (%d) and keycode (%d)", action, keyCode);
+    std::lock_guard<std::mutex> lock(inputLock);
     if (input) {
-        input->onKeyEvent(port, action, keyCode);
+        if (input->onKeyEvent(port, action, keyCode)) {
+            inputLatencyTracer.onEvent(port, eventTime);
+        }
     }
 }
 
@@ -261,7 +439,11 @@ void LibretroDroid::create(
     bool enableVirtualFileSystem,
     bool enableMicrophone,
     bool duplicateFrames,
+    bool threadedEmulation,
+    bool precisePacing,
     std::optional<ImmersiveMode::Config> immersiveModeConfig,
+    std::optional<RewindBuffer::Config> rewindConfig,
+    std::optional<WarmStart::Config> warmStartConfig,
     const std::string& language
 ) {
     LOGD("Performing libretrodroid create");
@@ -272,16 +454,26 @@ void LibretroDroid::create(
     Environment::getInstance().setLanguage(language);
     Environment::getInstance().setEnableVirtualFileSystem(enableVirtualFileSystem);
     Environment::getInstance().setEnableMicrophone(enableMicrophone);
+    Environment::getInstance().setMicrophoneInterface(MicrophoneInterface::getInterface());
+    Environment::getInstance().setTargetRefreshRate(refreshRate);
 
     openglESVersion = GLESVersion;
     screenRefreshRate = refreshRate;
     skipDuplicateFrames = duplicateFrames;
+    requestThreadedEmulation = threadedEmulation;
+    precisePacingEnabled = precisePacing;
     immersiveModeEnabled = GLESVersion >= 3 && immersiveModeConfig.has_value();
     this->immersiveModeConfig = immersiveModeConfig.value_or(ImmersiveMode::Config{});
+    this->rewindConfig = rewindConfig;
+    this->warmStartConfig = warmStartConfig;
     audioEnabled = true;
     frameSpeed = 1;
+    appliedFrameSpeed = 1;
+    rewinding = false;
+    runAheadFrames = 0;
 
-    core = std::make_unique<Core>(soFilePath);
+    core = acquireCore(soFilePath);
+    corePath = soFilePath;
 
     core->retro_set_video_refresh(&callback_hw_video_refresh);
     core->retro_set_environment(&Environment::callback_environment);
@@ -321,11 +513,13 @@ void LibretroDroid::loadGameFromPath(const std::string& gamePath) {
         game_info.data = nullptr;
         game_info.size = 0;
     } else {
-        struct Utils::ReadResult file = Utils::readFileAsBytes(gamePath);
-        game_info.data = file.data;
-        game_info.size = file.size;
+        gameFile = MappedFile::open(gamePath);
+        game_info.data = gameFile->getData();
+        game_info.size = gameFile->getSize();
     }
 
+    setGameContent(game_info, -1);
+
     bool result = core->retro_load_game(&game_info);
     if (!result) {
         LOGE("Cannot load game. Leaving.");
@@ -335,6 +529,11 @@ void LibretroDroid::loadGameFromPath(const std::string& gamePath) {
     afterGameLoad();
 }
 
+void LibretroDroid::loadGameFromBytes(std::vector<int8_t> data) {
+    gameBytes = std::move(data);
+    loadGameFromBytes(gameBytes.data(), gameBytes.size());
+}
+
 void LibretroDroid::loadGameFromBytes(const int8_t *data, size_t size) {
     LOGD("Performing libretrodroid loadGameFromBytes");
 
@@ -353,6 +552,8 @@ void LibretroDroid::loadGameFromBytes(const int8_t *data, size_t size) {
         game_info.size = size;
     }
 
+    setGameContent(game_info, -1);
+
     bool result = core->retro_load_game(&game_info);
     if (!result) {
         LOGE("Cannot load game. Leaving.");
@@ -381,6 +582,9 @@ void LibretroDroid::loadGameFromVirtualFiles(std::vector<VFSFile> virtualFiles)
     game_info.path = Utils::cloneToCString(firstFilePath);
     game_info.meta = nullptr;
 
+    // The identity is taken from the descriptor, which is closed once the file is mapped.
+    setGameContent(game_info, firstFileFD);
+
     if (loadUsingVFS) {
         VFS::getInstance().initialize(std::move(virtualFiles));
     }
@@ -389,9 +593,11 @@ void LibretroDroid::loadGameFromVirtualFiles(std::vector<VFSFile> virtualFiles)
         game_info.data = nullptr;
         game_info.size = 0;
     } else {
-        struct Utils::ReadResult file = Utils::readFileAsBytes(firstFileFD);
-        game_info.data = file.data;
-        game_info.size = file.size;
+        gameFile = MappedFile::open(firstFileFD);
+        game_info.data = gameFile->getData();
+        game_info.size = gameFile->getSize();
+        romData = game_info.data;
+        romSize = game_info.size;
     }
 
     bool result = core->retro_load_game(&game_info);
@@ -404,6 +610,8 @@ void LibretroDroid::loadGameFromVirtualFiles(std::vector<VFSFile> virtualFiles)
 }
 
 void LibretroDroid::destroy() {
+    stopEmulationThread();
+
     std::lock_guard<std::mutex> lock(coreLock);
 
     LOGD("Performing libretrodroid destroy");
@@ -415,11 +623,43 @@ void LibretroDroid::destroy() {
     core->retro_unload_game();
     core->retro_deinit();
 
+    PerfCounters::getInstance().clear();
+
+    if (warmStartConfig.has_value() && warmStartConfig->keepCoreLoaded) {
+        residentCore = std::move(core);
+        residentCorePath = corePath;
+    }
+
     video = nullptr;
     core = nullptr;
     rumble = nullptr;
     fpsSync = nullptr;
     audio = nullptr;
+    rewindBuffer = nullptr;
+    stateWriter = nullptr;
+    sramTracker = nullptr;
+    sramDirty = false;
+    {
+        std::lock_guard<std::mutex> storeLock(stateStoreLock);
+        stateStore = nullptr;
+    }
+    warmStart = nullptr;
+    warmStartPending = false;
+    movieRecorder = nullptr;
+    moviePlayer = nullptr;
+    videoFrames = nullptr;
+    pendingMessages.clear();
+    {
+        std::lock_guard<std::mutex> updatesLock(frameUpdatesLock);
+        frameUpdates = FrameUpdates {};
+    }
+
+    // The core might reference the game data until it is unloaded.
+    gameFile = nullptr;
+    gameBytes = std::vector<int8_t>();
+
+    serializeSize = 0;
+    serializeScratch = std::vector<int8_t>();
 
     Environment::getInstance().deinitialize();
     VFS::getInstance().deinitialize();
@@ -428,25 +668,61 @@ void LibretroDroid::destroy() {
 void LibretroDroid::resume() {
     LOGD("Performing libretrodroid resume");
 
-    input = std::make_unique<Input>();
+    {
+        std::lock_guard<std::mutex> lock(inputLock);
+        input = std::make_unique<Input>();
+    }
 
     fpsSync->reset();
+    frameSkipper.reset();
     audio->start();
     refreshAspectRatio();
+
+    startEmulationThread();
 }
 
 void LibretroDroid::pause() {
     LOGD("Performing libretrodroid pause");
+    stopEmulationThread();
+
     audio->stop();
 
+    std::lock_guard<std::mutex> lock(inputLock);
     input = nullptr;
 }
 
 void LibretroDroid::step() {
+    if (videoFrames) {
+        presentEmulatedFrame();
+        return;
+    }
+
+    startWarmStart();
+
     std::lock_guard<std::mutex> lock(coreLock);
 
     LOGD("Stepping into retro_run()");
 
+    bool frameRendered = runFrames();
+
+    // Like duplicated frames, skipped ones leave the previous frame on screen.
+    if (frameRendered && video && !video->rendersInVideoCallback()) {
+        video->renderFrame();
+    }
+
+    if (frameRendered) {
+        inputLatencyTracer.onFramePresented(inputLatencyTracer.getCurrentFrame() - 1);
+    }
+
+    if (fpsSync) {
+        fpsSync->wait();
+    }
+
+    handleFrameUpdates();
+    applyFrameUpdates();
+}
+
+bool LibretroDroid::runFrames() {
     unsigned frames = 1;
     if (fpsSync) {
         unsigned requestedFrames = fpsSync->advanceFrames();
@@ -455,40 +731,191 @@ void LibretroDroid::step() {
         frames = std::min(requestedFrames, 2u);
     }
 
-    for (size_t i = 0; i < frames * frameSpeed; i++)
-        core->retro_run();
+    unsigned speed = getFrameSpeed();
+    if (speed != appliedFrameSpeed) {
+        updateAudioSampleRateMultiplier();
+    }
+    updateThrottleState(speed);
 
-    if (video && !video->rendersInVideoCallback()) {
-        video->renderFrame();
+    bool skipVideo = shouldSkipFrame(speed);
+
+    // Only the last frame of the batch is going to be displayed, so we let the core skip video work
+    // for the previous ones. This is what keeps fast forward from being GPU bound.
+    size_t totalFrames = frames * speed;
+    for (size_t i = 0; i < totalFrames; i++) {
+        bool isLastFrame = i == totalFrames - 1;
+
+        if (isLastFrame && !skipVideo && isRunAheadEnabled()) {
+            runFrameAhead();
+        } else {
+            runFrame(isLastFrame && !skipVideo, true);
+
+            if (rewindBuffer && rewindBuffer->advanceFrame()) {
+                captureRewindSnapshot();
+            }
+        }
+
+        if (warmStart && warmStart->advanceFrame()) {
+            recordWarmStartSnapshot();
+        }
     }
 
-    if (fpsSync) {
-        fpsSync->wait();
+    if (sramTracker) {
+        updateSRAMTracker();
     }
 
-    if (rumble && rumbleEnabled) {
-        rumble->fetchFromEnvironment();
+    inputLatencyTracer.onFrameCompleted();
+
+    return !skipVideo;
+}
+
+// Fast forward already skips the video of most frames, so adaptive frame skip only kicks in at
+// normal speed.
+bool LibretroDroid::shouldSkipFrame(unsigned speed) {
+    if (!adaptiveFrameSkip || speed != 1) {
+        frameSkipper.reset();
+        return false;
     }
 
-    // Some games override the core geometry at runtime. These fields get updated in retro_run().
-    if (video && Environment::getInstance().isGameGeometryUpdated()) {
-        Environment::getInstance().clearGameGeometryUpdated();
+    double lateness = fpsSync ? fpsSync->getLateness() : 0.0;
+    double audioFillLevel = audio && audioEnabled ? audio->getBufferFillLevel() : 1.0;
+    return frameSkipper.shouldSkipFrame(lateness, audioFillLevel);
+}
+
+// Must be called by the thread running the core while holding coreLock.
+void LibretroDroid::handleFrameUpdates() {
+    Environment::getInstance().drainEvents([&](EnvironmentEvent& event) {
+        handleEnvironmentEvent(event);
+    });
+}
 
-        video->updateRendererSize(
-            Environment::getInstance().getGameGeometryWidth(),
-            Environment::getInstance().getGameGeometryHeight()
-        );
+void LibretroDroid::handleEnvironmentEvent(EnvironmentEvent& event) {
+    switch (event.type) {
+        // Some games override the core geometry at runtime.
+        case EnvironmentEvent::Type::GEOMETRY: {
+            std::lock_guard<std::mutex> lock(frameUpdatesLock);
+            frameUpdates.geometry = event.geometry;
+            break;
+        }
+
+        // Cores switching between PAL and NTSC or changing the audio rate mid game.
+        case EnvironmentEvent::Type::AV_INFO: {
+            {
+                std::lock_guard<std::mutex> lock(frameUpdatesLock);
+                frameUpdates.geometry = event.geometry;
+            }
+            updateTiming(event.timing.fps, event.timing.sampleRate);
+            break;
+        }
+
+        case EnvironmentEvent::Type::ROTATION: {
+            std::lock_guard<std::mutex> lock(frameUpdatesLock);
+            frameUpdates.rotation = event.rotation;
+            break;
+        }
+
+        case EnvironmentEvent::Type::RUMBLE: {
+            std::lock_guard<std::mutex> lock(frameUpdatesLock);
+            frameUpdates.rumbleStates[event.port] = event.rumbleState;
+            break;
+        }
 
+        // Cores which need more buffering to play without crackling.
+        case EnvironmentEvent::Type::AUDIO_LATENCY:
+            if (audio) {
+                audio->setMinimumLatency(event.minimumAudioLatencyMs);
+            }
+            break;
+
+        case EnvironmentEvent::Type::MESSAGE: {
+            std::lock_guard<std::mutex> lock(frameUpdatesLock);
+            if (frameUpdates.messages.size() >= MAX_PENDING_MESSAGES) {
+                frameUpdates.messages.pop_front();
+            }
+            frameUpdates.messages.push_back(std::move(event.message));
+            break;
+        }
+    }
+}
+
+// Must be called on the GL thread. Only the latest geometry, rotation and rumble state matter, so
+// intermediate values published between two frames are dropped.
+void LibretroDroid::applyFrameUpdates() {
+    FrameUpdates updates;
+    {
+        std::lock_guard<std::mutex> lock(frameUpdatesLock);
+        std::swap(updates, frameUpdates);
+    }
+
+    if (video && updates.geometry) {
+        video->updateRendererSize(updates.geometry->width, updates.geometry->height);
         dirtyVideo = true;
     }
 
-    if (video && Environment::getInstance().isScreenRotationUpdated()) {
-        Environment::getInstance().clearScreenRotationUpdated();
+    if (video && updates.rotation) {
+        video->updateRotation(*updates.rotation);
+    }
+
+    if (rumble && rumbleEnabled) {
+        for (auto& [port, rumbleState] : updates.rumbleStates) {
+            rumble->updateState(port, rumbleState);
+        }
+    }
 
-        video->updateRotation(Environment::getInstance().getScreenRotation());
+    for (auto& message : updates.messages) {
+        if (pendingMessages.size() >= MAX_PENDING_MESSAGES) {
+            pendingMessages.pop_front();
+        }
+        pendingMessages.push_back(std::move(message));
     }
 }
 
+// When the core runs on its own thread, the GL thread only uploads and draws the newest frame.
+void LibretroDroid::presentEmulatedFrame() {
+    applyFrameUpdates();
+
+    if (!video) return;
+
+    if (videoFrames->consume()) {
+        auto& frame = videoFrames->getReadBuffer();
+        video->onNewFrame(frame.data.data(), frame.width, frame.height, frame.pitch);
+    }
+
+    video->renderFrame();
+
+    inputLatencyTracer.onFramePresented(videoFrames->getReadBuffer().inputFrame);
+}
+
+void LibretroDroid::startEmulationThread() {
+    if (!videoFrames || emulationThreadRunning) return;
+
+    LOGI("Starting emulation thread");
+    emulationThreadRunning = true;
+    emulationThread = std::thread([this]() {
+        while (emulationThreadRunning) {
+            startWarmStart();
+
+            {
+                std::lock_guard<std::mutex> lock(coreLock);
+                runFrames();
+                handleFrameUpdates();
+            }
+
+            if (fpsSync) {
+                fpsSync->wait();
+            }
+        }
+    });
+}
+
+void LibretroDroid::stopEmulationThread() {
+    if (!emulationThreadRunning) return;
+
+    LOGI("Stopping emulation thread");
+    emulationThreadRunning = false;
+    emulationThread.join();
+}
+
 float LibretroDroid::getAspectRatio() {
     float gameAspectRatio = Environment::getInstance().retrieveGameSpecificAspectRatio();
     return gameAspectRatio > 0 ? gameAspectRatio : defaultAspectRatio;
@@ -506,9 +933,28 @@ bool LibretroDroid::isRumbleEnabled() const {
     return rumbleEnabled;
 }
 
+// The new speed is applied by the next frame, since the core might be overriding it.
 void LibretroDroid::setFrameSpeed(unsigned int speed) {
     frameSpeed = speed;
-    updateAudioSampleRateMultiplier();
+}
+
+void LibretroDroid::setRunAheadFrames(unsigned int frames) {
+    runAheadFrames = frames;
+}
+
+void LibretroDroid::setAdaptiveFrameSkip(bool enabled) {
+    adaptiveFrameSkip = enabled;
+}
+
+std::optional<FPSSync::Stats> LibretroDroid::getFrameTimingStats() {
+    if (!fpsSync) return std::nullopt;
+    return fpsSync->getStats();
+}
+
+void LibretroDroid::resetFrameTimingStats() {
+    if (fpsSync) {
+        fpsSync->resetStats();
+    }
 }
 
 void LibretroDroid::setAudioEnabled(bool enabled) {
@@ -528,6 +974,24 @@ void LibretroDroid::handleVideoRefresh(
     unsigned int height,
     size_t pitch
 ) {
+    if ((Environment::getInstance().getAudioVideoEnable() & Environment::AUDIO_VIDEO_ENABLE_VIDEO) == 0) {
+        return;
+    }
+
+    if (videoFrames) {
+        if (data != nullptr) {
+            auto& frame = videoFrames->getWriteBuffer();
+            auto bytes = static_cast<const uint8_t*>(data);
+            frame.data.assign(bytes, bytes + pitch * height);
+            frame.width = width;
+            frame.height = height;
+            frame.pitch = pitch;
+            frame.inputFrame = inputLatencyTracer.getCurrentFrame();
+            videoFrames->publish();
+        }
+        return;
+    }
+
     if (video) {
         video->onNewFrame(data, width, height, pitch);
 
@@ -538,6 +1002,10 @@ void LibretroDroid::handleVideoRefresh(
 }
 
 size_t LibretroDroid::handleAudioCallback(const int16_t *data, size_t frames) {
+    if ((Environment::getInstance().getAudioVideoEnable() & Environment::AUDIO_VIDEO_ENABLE_AUDIO) == 0) {
+        return frames;
+    }
+
     if (audio && audioEnabled) {
         audio->write(data, frames);
     }
@@ -550,10 +1018,25 @@ int16_t LibretroDroid::handleSetInputState(
     unsigned int index,
     unsigned int id
 ) {
-    if (input) {
-        return input->getInputState(port, device, index, id);
+    std::lock_guard<std::mutex> lock(inputLock);
+    int16_t result = 0;
+    if (moviePlayer) {
+        result = moviePlayer->getInputState(port, device, index, id);
+    } else if (input) {
+        inputLatencyTracer.onInputRead(port);
+        result = input->getInputState(port, device, index, id);
+
+        if (movieRecorder) {
+            movieRecorder->record(port, device, index, id, result);
+        }
     }
-    return 0;
+
+    // The boot snapshot is restored on every launch, so it must not contain any player input.
+    if (result != 0 && warmStart && warmStart->isRecording()) {
+        LOGI("Input detected while booting, not recording the boot snapshot");
+        warmStart->cancelRecording();
+    }
+    return result;
 }
 
 uintptr_t LibretroDroid::handleGetCurrentFrameBuffer() {
@@ -569,15 +1052,560 @@ void LibretroDroid::reset() {
     core->retro_reset();
 }
 
-std::pair<int8_t*, size_t> LibretroDroid::serializeState() {
+// Asking the core for the serialization size can be expensive, so it is cached unless the core
+// reports that it might change during emulation.
+size_t LibretroDroid::currentSerializeSize() {
+    if (Environment::getInstance().getSerializationQuirks() & RETRO_SERIALIZATION_QUIRK_CORE_VARIABLE_SIZE) {
+        serializeSize = core->retro_serialize_size();
+    }
+    return serializeSize;
+}
+
+size_t LibretroDroid::getSerializeSize() {
     std::lock_guard<std::mutex> lock(coreLock);
 
-    size_t size = core->retro_serialize_size();
-    auto data = new int8_t[size];
+    return currentSerializeSize();
+}
 
-    core->retro_serialize(data, size);
+size_t LibretroDroid::serializeState(int8_t* data, size_t size) {
+    std::lock_guard<std::mutex> lock(coreLock);
 
-    return std::pair(data, size);
+    size_t requiredSize = currentSerializeSize();
+    if (requiredSize == 0 || size < requiredSize) {
+        LOGE("Cannot serialize state: buffer of %zu bytes, required %zu", size, requiredSize);
+        return 0;
+    }
+
+    return core->retro_serialize(data, requiredSize) ? requiredSize : 0;
+}
+
+bool LibretroDroid::serializeState(const std::function<void(const int8_t*, size_t)>& consumer) {
+    std::lock_guard<std::mutex> lock(coreLock);
+
+    size_t size = currentSerializeSize();
+    serializeScratch.resize(size);
+
+    if (size == 0 || !core->retro_serialize(serializeScratch.data(), size)) {
+        return false;
+    }
+
+    consumer(serializeScratch.data(), size);
+    return true;
+}
+
+// The crc is only known when the game content is loaded in memory. Cores which need the full path
+// can read arbitrarily large files, so they are not hashed.
+// Reading the whole game can take a while for large images, so the checksum is only computed the
+// first time a state container needs it. Must be called while holding coreLock.
+uint32_t LibretroDroid::getRomCrc() {
+    if (!romCrc.has_value()) {
+        romCrc = romData != nullptr ? crc32(0, (const Bytef*) romData, romSize) : 0;
+    }
+    return romCrc.value();
+}
+
+StateContainer::Header LibretroDroid::buildStateHeader(size_t stateSize) {
+    struct retro_system_info system_info {};
+    core->retro_get_system_info(&system_info);
+
+    StateContainer::Header result;
+    result.apiVersion = core->retro_api_version();
+    result.coreName = system_info.library_name != nullptr ? system_info.library_name : "";
+    result.coreVersion = system_info.library_version != nullptr ? system_info.library_version : "";
+    result.stateSize = stateSize;
+    result.romCrc = getRomCrc();
+    return result;
+}
+
+bool LibretroDroid::isStateCompatible(const StateContainer::Header& header) {
+    StateContainer::Header expected = buildStateHeader(currentSerializeSize());
+
+    if (header.coreName != expected.coreName || header.apiVersion != expected.apiVersion) {
+        LOGE("Cannot load state created by %s", header.coreName.c_str());
+        return false;
+    }
+
+    if (header.romCrc != 0 && expected.romCrc != 0 && header.romCrc != expected.romCrc) {
+        LOGE("Cannot load state created for a different game");
+        return false;
+    }
+
+    bool variableSize =
+        Environment::getInstance().getSerializationQuirks() & RETRO_SERIALIZATION_QUIRK_CORE_VARIABLE_SIZE;
+
+    // Variable size states can grow, but not arbitrarily: the size is used to allocate the buffer.
+    bool sizeMismatch = variableSize
+        ? header.stateSize > expected.stateSize * MAX_VARIABLE_STATE_GROWTH
+        : header.stateSize != expected.stateSize;
+
+    if (sizeMismatch) {
+        LOGE("Cannot load state: size %llu, expected %llu",
+             (unsigned long long) header.stateSize,
+             (unsigned long long) expected.stateSize);
+        return false;
+    }
+
+    if (header.coreVersion != expected.coreVersion) {
+        LOGW("Loading state created by core version %s", header.coreVersion.c_str());
+    }
+
+    return true;
+}
+
+bool LibretroDroid::loadState(int fd) {
+    StateContainer::Reader reader(fd);
+    if (!reader.readHeader()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(coreLock);
+        if (isMovieActive()) {
+            LOGE("Cannot load state while an input movie is active");
+            return false;
+        }
+
+        if (!isStateCompatible(reader.getHeader())) {
+            return false;
+        }
+    }
+
+    // Decompression happens outside the lock, so the emulation keeps running meanwhile.
+    std::vector<int8_t> state(reader.getHeader().stateSize);
+    if (!reader.readState(state.data(), state.size())) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(coreLock);
+    if (isMovieActive()) {
+        LOGE("Cannot load state while an input movie is active");
+        return false;
+    }
+
+    return core->retro_unserialize(state.data(), state.size());
+}
+
+bool LibretroDroid::openStateStore(const std::string& directory) {
+    auto store = std::make_shared<ChunkStore>(directory);
+    if (!store->open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(stateStoreLock);
+    stateStore = std::move(store);
+    return true;
+}
+
+// The store can be replaced or closed by other threads, callers keep their own reference while
+// they access the disk. ChunkStore serializes the accesses internally.
+std::shared_ptr<ChunkStore> LibretroDroid::getStateStore() {
+    std::lock_guard<std::mutex> lock(stateStoreLock);
+    return stateStore;
+}
+
+bool LibretroDroid::saveStateToStore(const std::string& slot) {
+    auto store = getStateStore();
+    if (!store) {
+        LOGE("Cannot save state: the state store is not open");
+        return false;
+    }
+
+    std::vector<int8_t> state;
+    {
+        std::lock_guard<std::mutex> lock(coreLock);
+        if (!core) return false;
+
+        state.resize(currentSerializeSize());
+        if (state.empty() || !core->retro_serialize(state.data(), state.size())) {
+            return false;
+        }
+    }
+
+    return store->writeSlot(slot, state.data(), state.size());
+}
+
+bool LibretroDroid::loadStateFromStore(const std::string& slot) {
+    auto store = getStateStore();
+    if (!store) {
+        LOGE("Cannot load state: the state store is not open");
+        return false;
+    }
+
+    auto size = store->getSlotSize(slot);
+    if (!size.has_value()) {
+        return false;
+    }
+
+    std::vector<int8_t> state(size.value());
+    if (!store->readSlot(slot, state.data(), state.size())) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(coreLock);
+    if (!core) return false;
+
+    if (isMovieActive()) {
+        LOGE("Cannot load state while an input movie is active");
+        return false;
+    }
+
+    return core->retro_unserialize(state.data(), state.size());
+}
+
+bool LibretroDroid::deleteStateFromStore(const std::string& slot) {
+    auto store = getStateStore();
+    return store && store->deleteSlot(slot);
+}
+
+std::vector<std::string> LibretroDroid::getStoreSlots() {
+    auto store = getStateStore();
+    return store ? store->listSlots() : std::vector<std::string>();
+}
+
+size_t LibretroDroid::collectStoreGarbage() {
+    auto store = getStateStore();
+    return store ? store->collectGarbage() : 0;
+}
+
+void LibretroDroid::saveStateAsync(
+    int fd,
+    std::optional<StateContainer::Thumbnail> thumbnail,
+    StateWriter::Callback callback
+) {
+    std::lock_guard<std::mutex> lock(coreLock);
+
+    writeStateAsync(fd, std::move(thumbnail), std::move(callback));
+}
+
+// Must be called while holding coreLock.
+void LibretroDroid::writeStateAsync(
+    int fd,
+    std::optional<StateContainer::Thumbnail> thumbnail,
+    StateWriter::Callback callback
+) {
+    size_t size = currentSerializeSize();
+    if (!stateWriter || size == 0) {
+        close(fd);
+        throw LibretroDroidError("Serialization is not supported by this core", ERROR_SERIALIZATION);
+    }
+
+    std::vector<int8_t> state = stateWriter->acquireBuffer(size);
+    if (!core->retro_serialize(state.data(), size)) {
+        close(fd);
+        throw LibretroDroidError("Cannot serialize state", ERROR_SERIALIZATION);
+    }
+
+    stateWriter->submit(
+        std::move(state),
+        buildStateHeader(size),
+        std::move(thumbnail),
+        fd,
+        std::move(callback)
+    );
+}
+
+std::unique_ptr<Core> LibretroDroid::acquireCore(const std::string& soFilePath) {
+    bool keepCoreLoaded = warmStartConfig.has_value() && warmStartConfig->keepCoreLoaded;
+    if (keepCoreLoaded && residentCore && residentCorePath == soFilePath) {
+        LOGI("Reusing resident core %s", soFilePath.c_str());
+        return std::move(residentCore);
+    }
+
+    residentCore = nullptr;
+    return std::make_unique<Core>(soFilePath);
+}
+
+// Games loaded from files are identified by path, size and modification time, which does not
+// require reading them. The content checksum is only used for games loaded from memory.
+void LibretroDroid::setGameContent(const retro_game_info& gameInfo, int fd) {
+    romData = gameInfo.data;
+    romSize = gameInfo.size;
+    romCrc = std::nullopt;
+    gameIdentity.clear();
+
+    struct stat fileStat {};
+    bool found = gameInfo.path != nullptr &&
+        (fd >= 0 ? fstat(fd, &fileStat) == 0 : stat(gameInfo.path, &fileStat) == 0);
+
+    if (found) {
+        gameIdentity = std::string(gameInfo.path) + ":" +
+            std::to_string(fileStat.st_size) + ":" +
+            std::to_string(fileStat.st_mtime);
+    }
+}
+
+std::string LibretroDroid::getGameIdentity() {
+    if (gameIdentity.empty() && romData != nullptr) {
+        return std::to_string(getRomCrc()) + ":" + std::to_string(romSize);
+    }
+    return gameIdentity;
+}
+
+// Restores the boot snapshot if available, otherwise schedules its recording. It runs before the
+// first frame rather than in afterGameLoad(), since the application restores the SRAM in between.
+// Must be called before running the first frame, without holding coreLock. Reading and
+// decompressing the boot snapshot can take a while, so it happens outside the lock.
+void LibretroDroid::startWarmStart() {
+    if (!warmStartPending.exchange(false)) return;
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(coreLock);
+        if (!warmStart) return;
+
+        auto [sramData, sramSize] = getSRAMMemory();
+        StateContainer::Header header = buildStateHeader(currentSerializeSize());
+        path = warmStart->prepare(header, sramData, sramSize);
+    }
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGI("Boot snapshot not available, recording it");
+        std::lock_guard<std::mutex> lock(coreLock);
+        if (warmStart) {
+            warmStart->startRecording();
+        }
+        return;
+    }
+
+    StateContainer::Reader reader(fd);
+    bool compatible = false;
+    if (reader.readHeader()) {
+        std::lock_guard<std::mutex> lock(coreLock);
+        compatible = core && isStateCompatible(reader.getHeader());
+    }
+
+    std::vector<int8_t> snapshot;
+    if (compatible) {
+        snapshot.resize(reader.getHeader().stateSize);
+        compatible = reader.readState(snapshot.data(), snapshot.size());
+    }
+    close(fd);
+
+    std::lock_guard<std::mutex> lock(coreLock);
+    if (!core || !warmStart) return;
+
+    // The movie starts from its own state, restoring the boot snapshot would desync it.
+    if (isMovieActive()) {
+        LOGW("Skipping boot snapshot while an input movie is active");
+        return;
+    }
+
+    if (compatible && core->retro_unserialize(snapshot.data(), snapshot.size())) {
+        LOGI("Restored boot snapshot %s", path.c_str());
+    } else {
+        LOGW("Discarding invalid boot snapshot %s", path.c_str());
+        unlink(path.c_str());
+        warmStart->startRecording();
+    }
+}
+
+void LibretroDroid::recordWarmStartSnapshot() {
+    const std::string& path = warmStart->getSnapshotPath();
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("Cannot create boot snapshot %s: %s", path.c_str(), strerror(errno));
+        return;
+    }
+
+    try {
+        writeStateAsync(fd, std::nullopt, [path](bool success) {
+            if (success) {
+                LOGI("Recorded boot snapshot %s", path.c_str());
+            } else {
+                unlink(path.c_str());
+            }
+        });
+    } catch (std::exception& exception) {
+        LOGE("Cannot record boot snapshot: %s", exception.what());
+        unlink(path.c_str());
+    }
+}
+
+bool LibretroDroid::rewind(unsigned frames) {
+    std::lock_guard<std::mutex> lock(coreLock);
+
+    if (!rewindBuffer) {
+        LOGE("Cannot rewind: rewind is not enabled or not supported by this core");
+        return false;
+    }
+
+    if (isMovieActive()) {
+        LOGE("Cannot rewind while an input movie is active");
+        return false;
+    }
+
+    auto state = rewindBuffer->rewind(frames);
+    if (!state.has_value()) {
+        return false;
+    }
+
+    rewinding = true;
+    Environment::getInstance().setThrottleState(RETRO_THROTTLE_REWINDING, (float) contentTiming.fps);
+
+    auto [data, size] = state.value();
+    return core->retro_unserialize(data, size);
+}
+
+void LibretroDroid::captureRewindSnapshot() {
+    size_t size = currentSerializeSize();
+    if (size != rewindBuffer->getStateSize()) {
+        LOGI("Serialization size changed to %zu. Resetting rewind history.", size);
+        rewindBuffer->reset(size);
+    }
+
+    auto [data, capacity] = rewindBuffer->beginSnapshot();
+    if (core->retro_serialize(data, capacity)) {
+        rewindBuffer->commitSnapshot();
+    }
+}
+
+// Cores which support it skip their own rendering when the audio buffer runs low, which is a lot
+// cheaper than skipping frames in the frontend.
+void LibretroDroid::reportAudioBufferStatus(bool frameAudioEnabled) {
+    auto callback = Environment::getInstance().getAudioBufferStatusCallback();
+    if (!callback) return;
+
+    if (!audio || !audioEnabled || !frameAudioEnabled) {
+        callback(false, 0, false);
+        return;
+    }
+
+    double fillLevel = audio->getBufferFillLevel();
+    auto occupancy = (unsigned) std::lround(fillLevel * 100.0);
+    callback(true, std::min(occupancy, 100u), FrameSkipper::isAudioUnderrunLikely(fillLevel));
+}
+
+void LibretroDroid::runFrame(bool videoEnabled, bool audioEnabled) {
+    int flags = 0;
+    flags |= videoEnabled ? Environment::AUDIO_VIDEO_ENABLE_VIDEO : 0;
+    flags |= audioEnabled ? Environment::AUDIO_VIDEO_ENABLE_AUDIO : 0;
+    Environment::getInstance().setAudioVideoEnable(flags);
+
+    reportAudioBufferStatus(audioEnabled);
+
+    if (moviePlayer && !moviePlayer->beginFrame()) {
+        LOGI(
+            "Input movie finished after %llu frames with %llu mismatches",
+            (unsigned long long) moviePlayer->getFrames(),
+            (unsigned long long) moviePlayer->getMismatches()
+        );
+        moviePlayer = nullptr;
+    }
+
+    {
+        ScopedTiming timing(FrameTimings::PHASE_RETRO_RUN);
+        core->retro_run();
+    }
+
+    if (movieRecorder) {
+        movieRecorder->endFrame();
+    }
+}
+
+bool LibretroDroid::startMovieRecording(int fd) {
+    std::lock_guard<std::mutex> lock(coreLock);
+
+    size_t size = core && !isMovieActive() ? currentSerializeSize() : 0;
+    std::vector<int8_t> state(size);
+
+    if (size == 0 || !core->retro_serialize(state.data(), state.size())) {
+        LOGE("Cannot start input movie recording");
+        close(fd);
+        return false;
+    }
+
+    auto stateHeader = buildStateHeader(size);
+    InputMovie::Header header { stateHeader.coreName, stateHeader.coreVersion, stateHeader.romCrc };
+
+    movieRecorder = InputMovieRecorder::create(fd, header, state.data(), state.size());
+    return movieRecorder != nullptr;
+}
+
+bool LibretroDroid::startMoviePlayback(int fd) {
+    // Mapping the file happens outside the lock, so the emulation keeps running meanwhile.
+    auto player = InputMoviePlayer::create(fd);
+    if (!player) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(coreLock);
+    if (!core || isMovieActive()) {
+        return false;
+    }
+
+    StateContainer::Header header = buildStateHeader(player->getStateSize());
+    header.coreName = player->getHeader().coreName;
+    header.coreVersion = player->getHeader().coreVersion;
+    header.romCrc = player->getHeader().romCrc;
+
+    if (!isStateCompatible(header)) {
+        return false;
+    }
+
+    if (!core->retro_unserialize(player->getState(), player->getStateSize())) {
+        LOGE("Cannot restore the initial state of the input movie");
+        return false;
+    }
+
+    moviePlayer = std::move(player);
+    return true;
+}
+
+bool LibretroDroid::stopMovie() {
+    std::unique_ptr<InputMovieRecorder> recorder;
+    {
+        std::lock_guard<std::mutex> lock(coreLock);
+        recorder = std::move(movieRecorder);
+        moviePlayer = nullptr;
+    }
+
+    // Finishing waits for the pending blocks to be written and synced, the core can keep running.
+    return recorder ? recorder->finish() : true;
+}
+
+bool LibretroDroid::isMovieActive() const {
+    return movieRecorder != nullptr || moviePlayer != nullptr;
+}
+
+bool LibretroDroid::isRunAheadEnabled() const {
+    return runAheadFrames > 0 && runAheadSupported && !isMovieActive();
+}
+
+// Runs the real frame without presenting it, then emulates runAheadFrames frames with the same
+// input and shows the last one. The core is finally restored to the state after the real frame,
+// hiding the internal lag of the game.
+void LibretroDroid::runFrameAhead() {
+    runFrame(false, true);
+
+    if (rewindBuffer && rewindBuffer->advanceFrame()) {
+        captureRewindSnapshot();
+    }
+
+    if (Environment::getInstance().getSerializationQuirks() & RETRO_SERIALIZATION_QUIRK_CORE_VARIABLE_SIZE) {
+        runAheadState.resize(currentSerializeSize());
+    }
+
+    Environment::getInstance().setAudioVideoEnable(Environment::AUDIO_VIDEO_ENABLE_FAST_SAVESTATES);
+    if (core->retro_serialize(runAheadState.data(), runAheadState.size())) {
+        for (unsigned i = 1; i <= runAheadFrames; i++) {
+            runFrame(i == runAheadFrames, false);
+        }
+
+        Environment::getInstance().setAudioVideoEnable(Environment::AUDIO_VIDEO_ENABLE_FAST_SAVESTATES);
+        if (!core->retro_unserialize(runAheadState.data(), runAheadState.size())) {
+            LOGE("Cannot restore state for run-ahead. Disabling it.");
+            runAheadSupported = false;
+        }
+    } else {
+        LOGE("Cannot serialize state for run-ahead. Disabling it.");
+        runAheadSupported = false;
+    }
+
+    Environment::getInstance().setAudioVideoEnable(
+        Environment::AUDIO_VIDEO_ENABLE_VIDEO | Environment::AUDIO_VIDEO_ENABLE_AUDIO
+    );
 }
 
 void LibretroDroid::resetCheat() {
@@ -604,19 +1632,70 @@ void LibretroDroid::afterGameLoad() {
     struct retro_system_av_info system_av_info {};
     core->retro_get_system_av_info(&system_av_info);
 
-    fpsSync = std::make_unique<FPSSync>(system_av_info.timing.fps, screenRefreshRate);
+    // Hardware accelerated cores need the GL context, so they always run on the GL thread.
+    bool useEmulationThread = requestThreadedEmulation && !Environment::getInstance().isUseHwAcceleration();
+    if (useEmulationThread) {
+        videoFrames = std::make_unique<TripleBuffer<SoftwareFrame>>();
+    }
+
+    // The emulation thread is not throttled by the display, so it cannot rely on vsync.
+    fpsSync = std::make_unique<FPSSync>(
+        system_av_info.timing.fps,
+        screenRefreshRate,
+        !useEmulationThread,
+        precisePacingEnabled
+    );
 
     double inputSampleRate = system_av_info.timing.sample_rate * fpsSync->getTimeStretchFactor();
+    contentTiming = { system_av_info.timing.fps, system_av_info.timing.sample_rate };
 
     audio = std::make_unique<Audio>(
         (int32_t) std::lround(inputSampleRate),
         system_av_info.timing.fps,
-        preferLowLatencyAudio
+        preferLowLatencyAudio,
+        Environment::getInstance().getMinimumAudioLatency()
     );
 
     updateAudioSampleRateMultiplier();
 
     defaultAspectRatio = findDefaultAspectRatio(system_av_info);
+
+    serializeSize = core->retro_serialize_size();
+
+    if (serializeSize > 0) {
+        stateWriter = std::make_unique<StateWriter>();
+    }
+
+    auto [sramData, sramSize] = getSRAMMemory();
+    sramTracker = std::make_unique<SRAMTracker>();
+    sramTracker->reset((const uint8_t*) sramData, sramSize);
+
+    uint64_t serializationQuirks = Environment::getInstance().getSerializationQuirks();
+    bool incompleteSerialization = serializationQuirks & RETRO_SERIALIZATION_QUIRK_INCOMPLETE;
+
+    // The boot snapshot is restored in a later session, which these cores do not support.
+    bool warmStartSupported = serializeSize > 0 &&
+        !(serializationQuirks & (RETRO_SERIALIZATION_QUIRK_INCOMPLETE | RETRO_SERIALIZATION_QUIRK_SINGLE_SESSION));
+
+    bool warmStartEnabled = warmStartConfig.has_value() && !warmStartConfig->snapshotDirectory.empty();
+    std::string warmStartIdentity = warmStartEnabled && warmStartSupported ? getGameIdentity() : "";
+    if (!warmStartIdentity.empty()) {
+        warmStart = std::make_unique<WarmStart>(warmStartConfig.value(), warmStartIdentity);
+        warmStartPending = true;
+    } else if (warmStartEnabled) {
+        LOGI("Warm start is not supported by this core");
+    }
+
+    if (rewindConfig.has_value() && serializeSize > 0) {
+        rewindBuffer = std::make_unique<RewindBuffer>(serializeSize, rewindConfig.value());
+    }
+
+    runAheadSupported = serializeSize > 0 && !incompleteSerialization;
+    runAheadState.resize(serializeSize);
+
+    if (!runAheadSupported) {
+        LOGI("Run-ahead is not supported by this core");
+    }
 }
 
 float LibretroDroid::findDefaultAspectRatio(const retro_system_av_info& system_av_info) {
@@ -634,6 +1713,45 @@ void LibretroDroid::handleRumbleUpdates(const std::function<void(int, float, flo
     }
 }
 
+std::vector<PerfCounters::Counter> LibretroDroid::getPerfCounters() {
+    return PerfCounters::getInstance().getCounters();
+}
+
+void LibretroDroid::resetPerfCounters() {
+    PerfCounters::getInstance().reset();
+}
+
+void LibretroDroid::setPhaseTimingsEnabled(bool enabled) {
+    FrameTimings::getInstance().setEnabled(enabled);
+}
+
+std::vector<FrameTimings::Stats> LibretroDroid::getPhaseTimings() {
+    return FrameTimings::getInstance().getStats();
+}
+
+void LibretroDroid::resetPhaseTimings() {
+    FrameTimings::getInstance().reset();
+}
+
+void LibretroDroid::setInputLatencyTracingEnabled(bool enabled) {
+    inputLatencyTracer.setEnabled(enabled);
+}
+
+InputLatencyTracer::Stats LibretroDroid::getInputLatencyStats() {
+    return inputLatencyTracer.getStats();
+}
+
+void LibretroDroid::resetInputLatencyStats() {
+    inputLatencyTracer.reset();
+}
+
+void LibretroDroid::handleMessages(const std::function<void(const EnvironmentEvent::Message&)>& handler) {
+    while (!pendingMessages.empty()) {
+        handler(pendingMessages.front());
+        pendingMessages.pop_front();
+    }
+}
+
 void LibretroDroid::setViewport(Rect viewportRect) {
     this->viewportRect = viewportRect;
 
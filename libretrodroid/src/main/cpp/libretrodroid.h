@@ -28,6 +28,11 @@
 #include <mutex>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <deque>
+#include <map>
 
 #include "log.h"
 #include "core.h"
@@ -45,6 +50,18 @@
 #include "renderers/es2/imagerendereres2.h"
 #include "renderers/es3/imagerendereres3.h"
 #include "utils/rect.h"
+#include "rewindbuffer.h"
+#include "statewriter.h"
+#include "sramtracker.h"
+#include "chunkstore.h"
+#include "warmstart.h"
+#include "perfcounters.h"
+#include "frametimings.h"
+#include "inputlatencytracer.h"
+#include "inputmovie.h"
+#include "frameskipper.h"
+#include "utils/mappedfile.h"
+#include "utils/triplebuffer.h"
 
 namespace libretrodroid {
 
@@ -67,11 +84,49 @@ public:
     void setCheat(unsigned index, bool enabled, const std::string& code);
     void resetCheat();
 
-    std::pair<int8_t*, size_t> serializeState();
-    bool unserializeState(int8_t *data, size_t size);
+    size_t getSerializeSize();
 
-    std::pair<int8_t *, size_t> serializeSRAM();
-    jboolean unserializeSRAM(int8_t *data, size_t size);
+    // Serializes directly into caller owned memory, such as a direct ByteBuffer. Returns the size
+    // of the state, which can change between calls for some cores, or 0 on failure.
+    size_t serializeState(int8_t* data, size_t size);
+    bool unserializeState(const int8_t* data, size_t size);
+
+    // Serialize through a pooled scratch buffer, which is only valid during the callback.
+    bool serializeState(const std::function<void(const int8_t*, size_t)>& consumer);
+    bool unserializeState(size_t size, const std::function<void(int8_t*, size_t)>& producer);
+
+    // Serializes the state at the next frame boundary, compression and disk writes happen on a
+    // background thread. Takes ownership of the file descriptor.
+    void saveStateAsync(
+        int fd,
+        std::optional<StateContainer::Thumbnail> thumbnail,
+        StateWriter::Callback callback
+    );
+
+    // Loads a state written by saveStateAsync, rejecting the ones created by other cores or games.
+    bool loadState(int fd);
+
+    // Deduplicated save slots. Disk access happens outside the core lock.
+    bool openStateStore(const std::string& directory);
+    bool saveStateToStore(const std::string& slot);
+    bool loadStateFromStore(const std::string& slot);
+    bool deleteStateFromStore(const std::string& slot);
+    std::vector<std::string> getStoreSlots();
+    size_t collectStoreGarbage();
+
+    bool serializeSRAM(const std::function<void(const int8_t*, size_t)>& consumer);
+    jboolean unserializeSRAM(const int8_t* data, size_t size);
+    jboolean unserializeSRAM(size_t size, const std::function<void(int8_t*, size_t)>& producer);
+
+    // Memory owned by the core, valid until the game is unloaded. The core keeps writing into it,
+    // so it should only be read between frames.
+    std::pair<int8_t*, size_t> getSRAMBuffer();
+
+    // True when the save RAM changed since it was loaded or flushed.
+    bool isSRAMDirty();
+
+    // Writes only the changed pages into the save file. The file descriptor is not closed.
+    bool flushSRAM(int fd);
 
     void onSurfaceCreated();
     void onSurfaceChanged(unsigned int width, unsigned int height);
@@ -88,7 +143,11 @@ public:
         bool enableVirtualFileSystem,
         bool enableMicrophone,
         bool duplicateFrames,
+        bool threadedEmulation,
+        bool precisePacing,
         std::optional<ImmersiveMode::Config> immersiveModeConfig,
+        std::optional<RewindBuffer::Config> rewindConfig,
+        std::optional<WarmStart::Config> warmStartConfig,
         const std::string& language
     );
     void resume();
@@ -98,13 +157,26 @@ public:
 
     void reset();
 
+    bool rewind(unsigned frames);
+
+    // Input movies record the answers to input_state from the current state, replaying them gives
+    // frame exact runs. Run-ahead, rewind and loading states are disabled while a movie is active.
+    // Both take ownership of the file descriptor.
+    bool startMovieRecording(int fd);
+    bool startMoviePlayback(int fd);
+    bool stopMovie();
+    bool isMovieActive() const;
+
     void loadGameFromPath(const std::string &gamePath);
+    // The data must stay valid until destroy(), use the vector overload to hand over ownership.
     void loadGameFromBytes(const int8_t *data, size_t size);
+    void loadGameFromBytes(std::vector<int8_t> data);
     void loadGameFromVirtualFiles(std::vector<VFSFile> virtualFiles);
 
-    void onKeyEvent(unsigned int port, int action, int keyCode);
-    void onMotionEvent(unsigned int port, unsigned int source, float xAxis, float yAxis);
-    void onTouchEvent(float xAxis, float yAxis);
+    // Event times are CLOCK_MONOTONIC nanoseconds, they are only used to trace input latency.
+    void onKeyEvent(unsigned int port, int action, int keyCode, int64_t eventTime);
+    void onMotionEvent(unsigned int port, unsigned int source, float xAxis, float yAxis, int64_t eventTime);
+    void onTouchEvent(float xAxis, float yAxis, int64_t eventTime);
 
     void refreshAspectRatio();
     float getAspectRatio();
@@ -126,8 +198,32 @@ public:
     bool isRumbleEnabled() const;
     void handleRumbleUpdates(const std::function<void(int, float, float)> &handler);
 
+    // Messages the core asked to display, delivered in order on the GL thread.
+    void handleMessages(const std::function<void(const EnvironmentEvent::Message&)>& handler);
+
     void setFrameSpeed(unsigned int speed);
 
+    void setRunAheadFrames(unsigned int frames);
+
+    // Drops the video of frames which would make the audio stream underrun on slow devices.
+    void setAdaptiveFrameSkip(bool enabled);
+
+    std::optional<FPSSync::Stats> getFrameTimingStats();
+    void resetFrameTimingStats();
+
+    // Counters registered by the core through the libretro perf interface.
+    std::vector<PerfCounters::Counter> getPerfCounters();
+    void resetPerfCounters();
+
+    // Rolling statistics of the phases of each frame. Recording costs a branch while disabled.
+    void setPhaseTimingsEnabled(bool enabled);
+    std::vector<FrameTimings::Stats> getPhaseTimings();
+    void resetPhaseTimings();
+
+    void setInputLatencyTracingEnabled(bool enabled);
+    InputLatencyTracer::Stats getInputLatencyStats();
+    void resetInputLatencyStats();
+
     void setAudioEnabled(bool enabled);
 
     void setShaderConfig(ShaderManager::Config shaderConfig);
@@ -142,8 +238,42 @@ public:
 
 private:
     void updateAudioSampleRateMultiplier();
+    unsigned getFrameSpeed() const;
+    void updateThrottleState(unsigned speed);
+    void updateTiming(double fps, double sampleRate);
     float findDefaultAspectRatio(const retro_system_av_info &system_av_info);
     void afterGameLoad();
+    void captureRewindSnapshot();
+    size_t currentSerializeSize();
+    void updateSRAMTracker();
+    std::pair<int8_t*, size_t> getSRAMMemory();
+    uint32_t getRomCrc();
+    void setGameContent(const retro_game_info& gameInfo, int fd);
+    std::string getGameIdentity();
+    StateContainer::Header buildStateHeader(size_t stateSize);
+    std::shared_ptr<ChunkStore> getStateStore();
+    bool isStateCompatible(const StateContainer::Header& header);
+    void writeStateAsync(
+        int fd,
+        std::optional<StateContainer::Thumbnail> thumbnail,
+        StateWriter::Callback callback
+    );
+    std::unique_ptr<Core> acquireCore(const std::string& soFilePath);
+    void startWarmStart();
+    void recordWarmStartSnapshot();
+    // Returns false if the video of the last frame has been skipped.
+    bool runFrames();
+    bool shouldSkipFrame(unsigned speed);
+    void runFrame(bool videoEnabled, bool audioEnabled);
+    void reportAudioBufferStatus(bool frameAudioEnabled);
+    void runFrameAhead();
+    bool isRunAheadEnabled() const;
+    void handleFrameUpdates();
+    void handleEnvironmentEvent(EnvironmentEvent& event);
+    void applyFrameUpdates();
+    void presentEmulatedFrame();
+    void startEmulationThread();
+    void stopEmulationThread();
 
 protected:
     static void callback_hw_video_refresh(const void *data, unsigned width, unsigned height, size_t pitch);
@@ -154,7 +284,39 @@ protected:
     static void callback_retro_set_input_poll();
 
 private:
+    struct SoftwareFrame {
+        std::vector<uint8_t> data;
+        unsigned width = 0;
+        unsigned height = 0;
+        size_t pitch = 0;
+        uint64_t inputFrame = 0;
+    };
+
+    // Environment updates which have to be applied on the GL thread. The thread running the core
+    // publishes them here, so the GL thread never waits for coreLock to pick them up.
+    struct FrameUpdates {
+        std::optional<EnvironmentEvent::Geometry> geometry;
+        std::optional<float> rotation;
+        std::map<unsigned, RumbleState> rumbleStates;
+        std::deque<EnvironmentEvent::Message> messages;
+    };
+
+    static constexpr size_t MAX_PENDING_MESSAGES = 16;
+
+    // Used when a core forces fast forward without asking for a specific ratio.
+    static constexpr unsigned DEFAULT_FAST_FORWARD_SPEED = 2;
+
+    // Upper bound for states of cores with a variable serialization size, relative to the current one.
+    static constexpr uint64_t MAX_VARIABLE_STATE_GROWTH = 4;
+
     unsigned int frameSpeed = 1;
+    unsigned int appliedFrameSpeed = 1;
+    bool rewinding = false;
+    unsigned int runAheadFrames = 0;
+    bool adaptiveFrameSkip = false;
+    FrameSkipper frameSkipper;
+    bool runAheadSupported = false;
+    std::vector<int8_t> runAheadState;
     bool audioEnabled = true;
     bool preferLowLatencyAudio = false;
     bool rumbleEnabled = false;
@@ -167,13 +329,23 @@ private:
     float screenRefreshRate = 60.0;
     int openglESVersion = 2;
     bool skipDuplicateFrames = false;
+    bool requestThreadedEmulation = false;
+    bool precisePacingEnabled = false;
     bool immersiveModeEnabled = false;
     ImmersiveMode::Config immersiveModeConfig {};
+    std::optional<RewindBuffer::Config> rewindConfig;
+    std::optional<WarmStart::Config> warmStartConfig;
 
     float defaultAspectRatio = 1.0;
+    EnvironmentEvent::Timing contentTiming;
     bool dirtyVideo = false;
 
     std::mutex coreLock;
+    std::mutex inputLock;
+    std::mutex frameUpdatesLock;
+
+    std::thread emulationThread;
+    std::atomic<bool> emulationThreadRunning { false };
 
     std::unique_ptr<Core> core;
     std::unique_ptr<Audio> audio;
@@ -181,6 +353,36 @@ private:
     std::unique_ptr<FPSSync> fpsSync;
     std::unique_ptr<Input> input;
     std::unique_ptr<Rumble> rumble;
+    std::unique_ptr<RewindBuffer> rewindBuffer;
+    std::unique_ptr<StateWriter> stateWriter;
+    std::unique_ptr<SRAMTracker> sramTracker;
+    std::atomic<bool> sramDirty { false };
+    std::mutex sramFlushLock;
+    std::mutex stateStoreLock;
+    std::shared_ptr<ChunkStore> stateStore;
+    std::unique_ptr<WarmStart> warmStart;
+    std::atomic<bool> warmStartPending { false };
+    std::unique_ptr<InputMovieRecorder> movieRecorder;
+    std::unique_ptr<InputMoviePlayer> moviePlayer;
+
+    // Survives destroy() when warm start is enabled, so the next session can skip dlopen.
+    std::unique_ptr<Core> residentCore;
+    std::string residentCorePath;
+    std::string corePath;
+    std::string gameIdentity;
+
+    std::unique_ptr<MappedFile> gameFile;
+    std::vector<int8_t> gameBytes;
+
+    size_t serializeSize = 0;
+    const void* romData = nullptr;
+    size_t romSize = 0;
+    std::optional<uint32_t> romCrc;
+    std::vector<int8_t> serializeScratch;
+    std::unique_ptr<TripleBuffer<SoftwareFrame>> videoFrames;
+    FrameUpdates frameUpdates;
+    std::deque<EnvironmentEvent::Message> pendingMessages;
+    InputLatencyTracer inputLatencyTracer;
 };
 
 } //namespace libretrodroid
@@ -25,6 +25,8 @@
 #include <unordered_set>
 #include <mutex>
 #include <optional>
+#include <utility>
+#include <unistd.h>
 
 #include "libretrodroid.h"
 #include "log.h"
@@ -175,12 +177,11 @@ JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_unseri
     jbyteArray state
 ) {
     try {
-        jboolean isCopy = JNI_FALSE;
-        jbyte* data = env->GetByteArrayElements(state, &isCopy);
         jsize size = env->GetArrayLength(state);
 
-        bool result = LibretroDroid::getInstance().unserializeState(data, size);
-        env->ReleaseByteArrayElements(state, data, JNI_ABORT);
+        bool result = LibretroDroid::getInstance().unserializeState(size, [&](int8_t* data, size_t size) {
+            env->GetByteArrayRegion(state, 0, size, data);
+        });
 
         return result ? JNI_TRUE : JNI_FALSE;
 
@@ -196,10 +197,16 @@ JNIEXPORT jbyteArray JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_seri
     jclass obj
 ) {
     try {
-        auto [data, size] = LibretroDroid::getInstance().serializeState();
+        jbyteArray result = nullptr;
+
+        bool success = LibretroDroid::getInstance().serializeState([&](const int8_t* data, size_t size) {
+            result = env->NewByteArray(size);
+            env->SetByteArrayRegion(result, 0, size, data);
+        });
 
-        jbyteArray result = env->NewByteArray(size);
-        env->SetByteArrayRegion(result, 0, size, data);
+        if (!success) {
+            throw std::runtime_error("Cannot serialize state");
+        }
 
         return result;
 
@@ -211,6 +218,268 @@ JNIEXPORT jbyteArray JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_seri
     return nullptr;
 }
 
+JNIEXPORT jint JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_getSerializeSize(
+    JNIEnv* env,
+    jclass obj
+) {
+    try {
+        return (jint) LibretroDroid::getInstance().getSerializeSize();
+    } catch (std::exception &exception) {
+        LOGE("Error in getSerializeSize: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_serializeStateToBuffer(
+    JNIEnv* env,
+    jclass obj,
+    jobject buffer
+) {
+    try {
+        auto* data = (int8_t*) env->GetDirectBufferAddress(buffer);
+        jlong capacity = env->GetDirectBufferCapacity(buffer);
+        if (data == nullptr || capacity < 0) {
+            throw std::runtime_error("Buffer is not a direct ByteBuffer");
+        }
+
+        size_t size = LibretroDroid::getInstance().serializeState(data, capacity);
+        if (size == 0) {
+            throw std::runtime_error("Cannot serialize state");
+        }
+
+        return (jint) size;
+
+    } catch (std::exception &exception) {
+        LOGE("Error in serializeStateToBuffer: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return 0;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_unserializeStateFromBuffer(
+    JNIEnv* env,
+    jclass obj,
+    jobject buffer,
+    jint size
+) {
+    try {
+        auto* data = (const int8_t*) env->GetDirectBufferAddress(buffer);
+        jlong capacity = env->GetDirectBufferCapacity(buffer);
+        if (data == nullptr || size < 0 || size > capacity) {
+            throw std::runtime_error("Buffer is not a direct ByteBuffer or it is too small");
+        }
+
+        bool result = LibretroDroid::getInstance().unserializeState(data, size);
+        return result ? JNI_TRUE : JNI_FALSE;
+
+    } catch (std::exception &exception) {
+        LOGE("Error in unserializeStateFromBuffer: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_saveStateAsync(
+    JNIEnv* env,
+    jclass obj,
+    jint fd,
+    jobject thumbnail,
+    jobject callback
+) {
+    // The descriptor is owned by this function until it is handed to LibretroDroid.
+    int ownedFd = fd;
+
+    try {
+        std::optional<StateContainer::Thumbnail> nativeThumbnail;
+        if (thumbnail != nullptr) {
+            nativeThumbnail = JavaUtils::thumbnailFromJava(env, thumbnail);
+        }
+
+        JavaVM* vm = nullptr;
+        env->GetJavaVM(&vm);
+
+        jobject globalCallback = env->NewGlobalRef(callback);
+
+        auto onComplete = [vm, globalCallback](bool success) {
+            JavaUtils::withAttachedThread(vm, [&](JNIEnv* threadEnv) {
+                jclass callbackClass = threadEnv->GetObjectClass(globalCallback);
+                jmethodID onCompleteMethod = threadEnv->GetMethodID(callbackClass, "onComplete", "(Z)V");
+                threadEnv->CallVoidMethod(globalCallback, onCompleteMethod, success ? JNI_TRUE : JNI_FALSE);
+                threadEnv->DeleteLocalRef(callbackClass);
+                threadEnv->DeleteGlobalRef(globalCallback);
+            });
+        };
+
+        try {
+            int transferredFd = std::exchange(ownedFd, -1);
+            LibretroDroid::getInstance().saveStateAsync(transferredFd, std::move(nativeThumbnail), onComplete);
+        } catch (...) {
+            env->DeleteGlobalRef(globalCallback);
+            throw;
+        }
+
+    } catch (std::exception &exception) {
+        if (ownedFd >= 0) {
+            close(ownedFd);
+        }
+        LOGE("Error in saveStateAsync: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_loadState(
+    JNIEnv* env,
+    jclass obj,
+    jint fd
+) {
+    try {
+        return LibretroDroid::getInstance().loadState(fd) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in loadState: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jobject JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_readStateThumbnail(
+    JNIEnv* env,
+    jclass obj,
+    jint fd
+) {
+    try {
+        StateContainer::Reader reader(fd);
+        if (!reader.readHeader()) {
+            return nullptr;
+        }
+
+        auto thumbnail = reader.readThumbnail();
+        if (!thumbnail.has_value()) {
+            return nullptr;
+        }
+
+        jsize size = thumbnail->pixels.size();
+        jbyteArray pixels = env->NewByteArray(size);
+        env->SetByteArrayRegion(pixels, 0, size, (const jbyte*) thumbnail->pixels.data());
+
+        jclass thumbnailClass = env->FindClass("com/swordfish/libretrodroid/StateThumbnail");
+        jmethodID constructor = env->GetMethodID(thumbnailClass, "<init>", "(II[B)V");
+
+        return env->NewObject(
+            thumbnailClass,
+            constructor,
+            (jint) thumbnail->width,
+            (jint) thumbnail->height,
+            pixels
+        );
+
+    } catch (std::exception &exception) {
+        LOGE("Error in readStateThumbnail: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+    }
+
+    return nullptr;
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_openStateStore(
+    JNIEnv* env,
+    jclass obj,
+    jstring directory
+) {
+    try {
+        auto directoryString = JniString(env, directory);
+        return LibretroDroid::getInstance().openStateStore(directoryString.stdString()) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in openStateStore: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_saveStateToStore(
+    JNIEnv* env,
+    jclass obj,
+    jstring slot
+) {
+    try {
+        auto slotString = JniString(env, slot);
+        return LibretroDroid::getInstance().saveStateToStore(slotString.stdString()) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in saveStateToStore: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_loadStateFromStore(
+    JNIEnv* env,
+    jclass obj,
+    jstring slot
+) {
+    try {
+        auto slotString = JniString(env, slot);
+        return LibretroDroid::getInstance().loadStateFromStore(slotString.stdString()) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in loadStateFromStore: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_deleteStateFromStore(
+    JNIEnv* env,
+    jclass obj,
+    jstring slot
+) {
+    try {
+        auto slotString = JniString(env, slot);
+        return LibretroDroid::getInstance().deleteStateFromStore(slotString.stdString()) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in deleteStateFromStore: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jobjectArray JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_getStoreSlots(
+    JNIEnv* env,
+    jclass obj
+) {
+    try {
+        auto slots = LibretroDroid::getInstance().getStoreSlots();
+
+        jclass stringClass = env->FindClass("java/lang/String");
+        jobjectArray result = env->NewObjectArray(slots.size(), stringClass, nullptr);
+
+        for (size_t i = 0; i < slots.size(); i++) {
+            jstring jSlot = env->NewStringUTF(slots[i].c_str());
+            env->SetObjectArrayElement(result, i, jSlot);
+            env->DeleteLocalRef(jSlot);
+        }
+
+        return result;
+
+    } catch (std::exception &exception) {
+        LOGE("Error in getStoreSlots: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+    }
+
+    return nullptr;
+}
+
+JNIEXPORT jint JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_collectStoreGarbage(
+    JNIEnv* env,
+    jclass obj
+) {
+    try {
+        return (jint) LibretroDroid::getInstance().collectStoreGarbage();
+    } catch (std::exception &exception) {
+        LOGE("Error in collectStoreGarbage: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return 0;
+    }
+}
+
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_setCheat(
     JNIEnv* env,
     jclass obj,
@@ -245,21 +514,17 @@ JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_unseri
     jbyteArray sram
 ) {
     try {
-        jboolean isCopy = JNI_FALSE;
-        jbyte* data = env->GetByteArrayElements(sram, &isCopy);
         jsize size = env->GetArrayLength(sram);
 
-        LibretroDroid::getInstance().unserializeSRAM(data, size);
-
-        env->ReleaseByteArrayElements(sram, data, JNI_ABORT);
+        return LibretroDroid::getInstance().unserializeSRAM(size, [&](int8_t* data, size_t size) {
+            env->GetByteArrayRegion(sram, 0, size, data);
+        });
 
     } catch (std::exception &exception) {
         LOGE("Error in unserializeSRAM: %s", exception.what());
         JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
         return JNI_FALSE;
     }
-
-    return JNI_TRUE;
 }
 
 JNIEXPORT jbyteArray JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_serializeSRAM(
@@ -267,12 +532,14 @@ JNIEXPORT jbyteArray JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_seri
     jclass obj
 ) {
     try {
-        auto [data, size] = LibretroDroid::getInstance().serializeSRAM();
+        jbyteArray result = nullptr;
 
-        jbyteArray result = env->NewByteArray(size);
-        env->SetByteArrayRegion(result, 0, size, (jbyte *) data);
+        LibretroDroid::getInstance().serializeSRAM([&](const int8_t* data, size_t size) {
+            result = env->NewByteArray(size);
+            env->SetByteArrayRegion(result, 0, size, data);
+        });
 
-        return result;
+        return result != nullptr ? result : env->NewByteArray(0);
 
     } catch (std::exception &exception) {
         LOGE("Error in serializeSRAM: %s", exception.what());
@@ -282,6 +549,53 @@ JNIEXPORT jbyteArray JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_seri
     return nullptr;
 }
 
+JNIEXPORT jobject JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_getSRAMBuffer(
+    JNIEnv* env,
+    jclass obj
+) {
+    try {
+        auto [data, size] = LibretroDroid::getInstance().getSRAMBuffer();
+        if (data == nullptr) {
+            return nullptr;
+        }
+
+        return env->NewDirectByteBuffer(data, size);
+
+    } catch (std::exception &exception) {
+        LOGE("Error in getSRAMBuffer: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+    }
+
+    return nullptr;
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_isSRAMDirty(
+    JNIEnv* env,
+    jclass obj
+) {
+    try {
+        return LibretroDroid::getInstance().isSRAMDirty() ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in isSRAMDirty: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_flushSRAM(
+    JNIEnv* env,
+    jclass obj,
+    jint fd
+) {
+    try {
+        return LibretroDroid::getInstance().flushSRAM(fd) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in flushSRAM: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_reset(
     JNIEnv* env,
     jclass obj
@@ -294,6 +608,55 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_reset(
     }
 }
 
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_rewind(
+    JNIEnv* env,
+    jclass obj,
+    jint frames
+) {
+    try {
+        return LibretroDroid::getInstance().rewind(frames) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in rewind: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_startMovieRecording(
+    JNIEnv* env,
+    jclass obj,
+    jint fd
+) {
+    try {
+        return LibretroDroid::getInstance().startMovieRecording(fd) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in startMovieRecording: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_startMoviePlayback(
+    JNIEnv* env,
+    jclass obj,
+    jint fd
+) {
+    try {
+        return LibretroDroid::getInstance().startMoviePlayback(fd) ? JNI_TRUE : JNI_FALSE;
+    } catch (std::exception &exception) {
+        LOGE("Error in startMoviePlayback: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_SERIALIZATION);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_stopMovie(
+    JNIEnv* env,
+    jclass obj
+) {
+    return LibretroDroid::getInstance().stopMovie() ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_onSurfaceChanged(
     JNIEnv* env,
     jclass obj,
@@ -316,18 +679,20 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_onMotionEv
     jint port,
     jint source,
     jfloat xAxis,
-    jfloat yAxis
+    jfloat yAxis,
+    jlong eventTime
 ) {
-    LibretroDroid::getInstance().onMotionEvent(port, source, xAxis, yAxis);
+    LibretroDroid::getInstance().onMotionEvent(port, source, xAxis, yAxis, eventTime);
 }
 
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_onTouchEvent(
     JNIEnv* env,
     jclass obj,
     jfloat xAxis,
-    jfloat yAxis
+    jfloat yAxis,
+    jlong eventTime
 ) {
-    LibretroDroid::getInstance().onTouchEvent(xAxis, yAxis);
+    LibretroDroid::getInstance().onTouchEvent(xAxis, yAxis, eventTime);
 }
 
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_onKeyEvent(
@@ -335,9 +700,10 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_onKeyEvent
     jclass obj,
     jint port,
     jint action,
-    jint keyCode
+    jint keyCode,
+    jlong eventTime
 ) {
-    LibretroDroid::getInstance().onKeyEvent(port, action, keyCode);
+    LibretroDroid::getInstance().onKeyEvent(port, action, keyCode, eventTime);
 }
 
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_create(
@@ -354,7 +720,11 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_create(
     jboolean enableVirtualFileSystem,
     jboolean enableMicrophone,
     jboolean skipDuplicateFrames,
+    jboolean threadedEmulation,
+    jboolean precisePacing,
     jobject immersiveMode,
+    jobject rewindConfig,
+    jobject warmStartConfig,
     jstring language
 ) {
     try {
@@ -391,6 +761,36 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_create(
             parsedConfig = config;
         }
 
+        std::optional<RewindBuffer::Config> parsedRewindConfig = std::nullopt;
+        if (rewindConfig != nullptr) {
+            jclass configClass = env->GetObjectClass(rewindConfig);
+            jfieldID memoryBudgetField = env->GetFieldID(configClass, "memoryBudget", "J");
+            jfieldID frameIntervalField = env->GetFieldID(configClass, "frameInterval", "I");
+
+            RewindBuffer::Config config {};
+            config.memoryBudget = env->GetLongField(rewindConfig, memoryBudgetField);
+            config.frameInterval = env->GetIntField(rewindConfig, frameIntervalField);
+            parsedRewindConfig = config;
+        }
+
+        std::optional<WarmStart::Config> parsedWarmStartConfig = std::nullopt;
+        if (warmStartConfig != nullptr) {
+            jclass configClass = env->GetObjectClass(warmStartConfig);
+            jfieldID keepCoreLoadedField = env->GetFieldID(configClass, "keepCoreLoaded", "Z");
+            jfieldID snapshotDirectoryField = env->GetFieldID(configClass, "snapshotDirectory", "Ljava/lang/String;");
+            jfieldID bootFramesField = env->GetFieldID(configClass, "bootFrames", "I");
+
+            WarmStart::Config config {};
+            config.keepCoreLoaded = env->GetBooleanField(warmStartConfig, keepCoreLoadedField);
+            config.bootFrames = env->GetIntField(warmStartConfig, bootFramesField);
+
+            auto jSnapshotDirectory = (jstring) env->GetObjectField(warmStartConfig, snapshotDirectoryField);
+            if (jSnapshotDirectory != nullptr) {
+                config.snapshotDirectory = JniString(env, jSnapshotDirectory).stdString();
+            }
+            parsedWarmStartConfig = config;
+        }
+
         LibretroDroid::getInstance().create(
             GLESVersion,
             corePath.stdString(),
@@ -403,7 +803,11 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_create(
             enableVirtualFileSystem,
             enableMicrophone,
             skipDuplicateFrames,
+            threadedEmulation,
+            precisePacing,
             parsedConfig,
+            parsedRewindConfig,
+            parsedWarmStartConfig,
             deviceLanguage.stdString()
         );
 
@@ -438,20 +842,47 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_loadGameFr
 ) {
     try {
         size_t size = env->GetArrayLength(gameFileBytes);
-        auto* data = new int8_t[size];
-        env->GetByteArrayRegion(
-            gameFileBytes,
-            0,
-            size,
-            reinterpret_cast<int8_t*>(data)
-        );
-        LibretroDroid::getInstance().loadGameFromBytes(data, size);
+        std::vector<int8_t> data(size);
+        env->GetByteArrayRegion(gameFileBytes, 0, size, data.data());
+        LibretroDroid::getInstance().loadGameFromBytes(std::move(data));
     } catch (std::exception &exception) {
         LOGE("Error in loadGameFromBytes: %s", exception.what());
         JavaUtils::throwRetroException(env, ERROR_LOAD_GAME);
     }
 }
 
+// The buffer is used in place, so we keep a reference to it until the game is unloaded.
+static jobject gameFileBufferRef = nullptr;
+
+static void releaseGameFileBuffer(JNIEnv* env) {
+    if (gameFileBufferRef != nullptr) {
+        env->DeleteGlobalRef(gameFileBufferRef);
+        gameFileBufferRef = nullptr;
+    }
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_loadGameFromBuffer(
+    JNIEnv* env,
+    jclass obj,
+    jobject gameFileBuffer
+) {
+    try {
+        auto* data = (const int8_t*) env->GetDirectBufferAddress(gameFileBuffer);
+        jlong size = env->GetDirectBufferCapacity(gameFileBuffer);
+        if (data == nullptr || size < 0) {
+            throw std::runtime_error("Game buffer is not a direct ByteBuffer");
+        }
+
+        releaseGameFileBuffer(env);
+        gameFileBufferRef = env->NewGlobalRef(gameFileBuffer);
+
+        LibretroDroid::getInstance().loadGameFromBytes(data, size);
+    } catch (std::exception &exception) {
+        LOGE("Error in loadGameFromBuffer: %s", exception.what());
+        JavaUtils::throwRetroException(env, ERROR_LOAD_GAME);
+    }
+}
+
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_loadGameFromVirtualFiles(
         JNIEnv* env,
         jclass obj,
@@ -495,6 +926,7 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_destroy(
 ) {
     try {
         LibretroDroid::getInstance().destroy();
+        releaseGameFileBuffer(env);
     } catch (std::exception &exception) {
         LOGE("Error in destroy: %s", exception.what());
         JavaUtils::throwRetroException(env, ERROR_GENERIC);
@@ -546,6 +978,14 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_step(
             env->CallVoidMethod(glRetroView, sendRumbleStrengthMethodID, port, weak, strong);
         });
     }
+
+    LibretroDroid::getInstance().handleMessages([&](const EnvironmentEvent::Message& message) {
+        jclass cls = env->GetObjectClass(glRetroView);
+        jmethodID sendMessageMethodID = env->GetMethodID(cls, "sendMessageEvent", "(Ljava/lang/String;II)V");
+        jstring text = env->NewStringUTF(message.text.c_str());
+        env->CallVoidMethod(glRetroView, sendMessageMethodID, text, (jint) message.durationMs, (jint) message.priority);
+        env->DeleteLocalRef(text);
+    });
 }
 
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_setRumbleEnabled(
@@ -564,6 +1004,180 @@ JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_setFrameSp
     LibretroDroid::getInstance().setFrameSpeed(speed);
 }
 
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_setRunAheadFrames(
+    JNIEnv* env,
+    jclass obj,
+    jint frames
+) {
+    LibretroDroid::getInstance().setRunAheadFrames(frames);
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_setAdaptiveFrameSkip(
+    JNIEnv* env,
+    jclass obj,
+    jboolean enabled
+) {
+    LibretroDroid::getInstance().setAdaptiveFrameSkip(enabled);
+}
+
+JNIEXPORT jobject JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_getFrameTimingStats(
+    JNIEnv* env,
+    jclass obj
+) {
+    auto stats = LibretroDroid::getInstance().getFrameTimingStats();
+    if (!stats.has_value()) return nullptr;
+
+    jclass statsClass = env->FindClass("com/swordfish/libretrodroid/FrameTimingStats");
+    jmethodID statsConstructor = env->GetMethodID(statsClass, "<init>", "(JJDDD)V");
+
+    return env->NewObject(
+        statsClass,
+        statsConstructor,
+        (jlong) stats->frames,
+        (jlong) stats->lateFrames,
+        (jdouble) stats->meanError,
+        (jdouble) stats->rmsError,
+        (jdouble) stats->maxError
+    );
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_resetFrameTimingStats(
+    JNIEnv* env,
+    jclass obj
+) {
+    LibretroDroid::getInstance().resetFrameTimingStats();
+}
+
+JNIEXPORT jobjectArray JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_getPerfCounters(
+    JNIEnv* env,
+    jclass obj
+) {
+    auto counters = LibretroDroid::getInstance().getPerfCounters();
+
+    jclass counterClass = env->FindClass("com/swordfish/libretrodroid/PerfCounter");
+    jmethodID counterConstructor = env->GetMethodID(counterClass, "<init>", "(Ljava/lang/String;JJ)V");
+    jobjectArray result = env->NewObjectArray(counters.size(), counterClass, nullptr);
+
+    for (size_t i = 0; i < counters.size(); i++) {
+        jstring name = env->NewStringUTF(counters[i].name.c_str());
+        jobject counter = env->NewObject(
+            counterClass,
+            counterConstructor,
+            name,
+            (jlong) counters[i].totalNs,
+            (jlong) counters[i].calls
+        );
+        env->SetObjectArrayElement(result, i, counter);
+        env->DeleteLocalRef(counter);
+        env->DeleteLocalRef(name);
+    }
+
+    return result;
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_resetPerfCounters(
+    JNIEnv* env,
+    jclass obj
+) {
+    LibretroDroid::getInstance().resetPerfCounters();
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_setPhaseTimingsEnabled(
+    JNIEnv* env,
+    jclass obj,
+    jboolean enabled
+) {
+    LibretroDroid::getInstance().setPhaseTimingsEnabled(enabled);
+}
+
+JNIEXPORT jobjectArray JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_getPhaseTimings(
+    JNIEnv* env,
+    jclass obj
+) {
+    auto timings = LibretroDroid::getInstance().getPhaseTimings();
+
+    jclass statsClass = env->FindClass("com/swordfish/libretrodroid/PhaseTimingStats");
+    jmethodID statsConstructor = env->GetMethodID(statsClass, "<init>", "(Ljava/lang/String;IJJJJ)V");
+    jobjectArray result = env->NewObjectArray(timings.size(), statsClass, nullptr);
+
+    for (size_t i = 0; i < timings.size(); i++) {
+        jstring phase = env->NewStringUTF(FrameTimings::getPhaseName(timings[i].phase));
+        jobject stats = env->NewObject(
+            statsClass,
+            statsConstructor,
+            phase,
+            (jint) timings[i].samples,
+            (jlong) timings[i].min,
+            (jlong) timings[i].p50,
+            (jlong) timings[i].p95,
+            (jlong) timings[i].max
+        );
+        env->SetObjectArrayElement(result, i, stats);
+        env->DeleteLocalRef(stats);
+        env->DeleteLocalRef(phase);
+    }
+
+    return result;
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_resetPhaseTimings(
+    JNIEnv* env,
+    jclass obj
+) {
+    LibretroDroid::getInstance().resetPhaseTimings();
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_setInputLatencyTracingEnabled(
+    JNIEnv* env,
+    jclass obj,
+    jboolean enabled
+) {
+    LibretroDroid::getInstance().setInputLatencyTracingEnabled(enabled);
+}
+
+JNIEXPORT jobject JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_getInputLatencyStats(
+    JNIEnv* env,
+    jclass obj
+) {
+    auto stats = LibretroDroid::getInstance().getInputLatencyStats();
+
+    jclass distributionClass = env->FindClass("com/swordfish/libretrodroid/LatencyDistribution");
+    jmethodID distributionConstructor = env->GetMethodID(distributionClass, "<init>", "(IJJJJ)V");
+
+    auto buildDistribution = [&](const InputLatencyTracer::Distribution& distribution) {
+        return env->NewObject(
+            distributionClass,
+            distributionConstructor,
+            (jint) distribution.samples,
+            (jlong) distribution.min,
+            (jlong) distribution.p50,
+            (jlong) distribution.p95,
+            (jlong) distribution.max
+        );
+    };
+
+    jclass statsClass = env->FindClass("com/swordfish/libretrodroid/InputLatencyStats");
+    jmethodID statsConstructor = env->GetMethodID(
+        statsClass,
+        "<init>",
+        "(Lcom/swordfish/libretrodroid/LatencyDistribution;Lcom/swordfish/libretrodroid/LatencyDistribution;)V"
+    );
+
+    return env->NewObject(
+        statsClass,
+        statsConstructor,
+        buildDistribution(stats.toRead),
+        buildDistribution(stats.toPresent)
+    );
+}
+
+JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_resetInputLatencyStats(
+    JNIEnv* env,
+    jclass obj
+) {
+    LibretroDroid::getInstance().resetInputLatencyStats();
+}
+
 JNIEXPORT void JNICALL Java_com_swordfish_libretrodroid_LibretroDroid_setAudioEnabled(
     JNIEnv* env,
     jclass obj,
@@ -0,0 +1,198 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "perfcounters.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+#if defined(__aarch64__) || defined(__arm__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#include "log.h"
+
+namespace libretrodroid {
+
+static uint64_t monotonicNanos() {
+    struct timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+void PerfCounters::fillCallback(struct retro_perf_callback* callback) {
+    callback->get_time_usec = &callback_get_time_usec;
+    callback->get_cpu_features = &callback_get_cpu_features;
+    callback->get_perf_counter = &callback_get_perf_counter;
+    callback->perf_register = &callback_perf_register;
+    callback->perf_start = &callback_perf_start;
+    callback->perf_stop = &callback_perf_stop;
+    callback->perf_log = &callback_perf_log;
+}
+
+retro_time_t PerfCounters::callback_get_time_usec() {
+    return (retro_time_t) (monotonicNanos() / 1000);
+}
+
+uint64_t PerfCounters::callback_get_cpu_features() {
+    uint64_t result = 0;
+
+#if defined(__aarch64__)
+    unsigned long hwcap = getauxval(AT_HWCAP);
+    result |= RETRO_SIMD_NEON | RETRO_SIMD_VFPV3 | RETRO_SIMD_VFPV4;
+    if (hwcap & HWCAP_ASIMD) result |= RETRO_SIMD_ASIMD;
+    if (hwcap & HWCAP_AES) result |= RETRO_SIMD_AES;
+#elif defined(__arm__)
+    unsigned long hwcap = getauxval(AT_HWCAP);
+    if (hwcap & HWCAP_NEON) result |= RETRO_SIMD_NEON;
+    if (hwcap & HWCAP_VFPv3) result |= RETRO_SIMD_VFPV3;
+    if (hwcap & HWCAP_VFPv4) result |= RETRO_SIMD_VFPV4;
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("cmov")) result |= RETRO_SIMD_CMOV;
+    if (__builtin_cpu_supports("mmx")) result |= RETRO_SIMD_MMX;
+    if (__builtin_cpu_supports("sse")) result |= RETRO_SIMD_SSE | RETRO_SIMD_MMXEXT;
+    if (__builtin_cpu_supports("sse2")) result |= RETRO_SIMD_SSE2;
+    if (__builtin_cpu_supports("sse3")) result |= RETRO_SIMD_SSE3;
+    if (__builtin_cpu_supports("ssse3")) result |= RETRO_SIMD_SSSE3;
+    if (__builtin_cpu_supports("sse4.1")) result |= RETRO_SIMD_SSE4;
+    if (__builtin_cpu_supports("sse4.2")) result |= RETRO_SIMD_SSE42;
+    if (__builtin_cpu_supports("popcnt")) result |= RETRO_SIMD_POPCNT;
+    if (__builtin_cpu_supports("avx")) result |= RETRO_SIMD_AVX;
+    if (__builtin_cpu_supports("avx2")) result |= RETRO_SIMD_AVX2;
+#endif
+
+    return result;
+}
+
+retro_perf_tick_t PerfCounters::callback_get_perf_counter() {
+    return (retro_perf_tick_t) monotonicNanos();
+}
+
+void PerfCounters::callback_perf_register(struct retro_perf_counter* counter) {
+    PerfCounters::getInstance().registerCounter(counter);
+}
+
+void PerfCounters::callback_perf_start(struct retro_perf_counter* counter) {
+    if (counter == nullptr) return;
+    counter->call_cnt++;
+    counter->start = callback_get_perf_counter();
+}
+
+void PerfCounters::callback_perf_stop(struct retro_perf_counter* counter) {
+    if (counter == nullptr) return;
+    counter->total += callback_get_perf_counter() - counter->start;
+}
+
+void PerfCounters::callback_perf_log() {
+    for (const auto& counter : PerfCounters::getInstance().getCounters()) {
+        LOGI(
+            "Perf counter %s: %llu ns in %llu calls",
+            counter.name.c_str(),
+            (unsigned long long) counter.totalNs,
+            (unsigned long long) counter.calls
+        );
+    }
+}
+
+void PerfCounters::registerCounter(struct retro_perf_counter* counter) {
+    if (counter == nullptr || counter->registered) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (counters.size() >= MAX_COUNTERS) {
+        LOGW("Too many perf counters, ignoring %s", counter->ident);
+        return;
+    }
+
+    counter->registered = true;
+    counters.push_back(counter);
+}
+
+std::vector<PerfCounters::Counter> PerfCounters::getCounters() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<Counter> result;
+    result.reserve(counters.size());
+
+    for (auto* counter : counters) {
+        result.push_back(Counter {
+            counter->ident != nullptr ? counter->ident : "",
+            counter->total,
+            counter->call_cnt
+        });
+    }
+
+    std::sort(result.begin(), result.end(), [](const Counter& first, const Counter& second) {
+        return first.totalNs > second.totalNs;
+    });
+
+    return result;
+}
+
+std::string PerfCounters::toJson() {
+    std::string result = "[";
+
+    auto values = getCounters();
+    for (size_t i = 0; i < values.size(); i++) {
+        std::string name;
+        for (char c : values[i].name) {
+            if (c == '"' || c == '\\') name += '\\';
+            if ((unsigned char) c >= 0x20) name += c;
+        }
+
+        char buffer[128];
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "\", \"total_ns\": %llu, \"calls\": %llu}",
+            (unsigned long long) values[i].totalNs,
+            (unsigned long long) values[i].calls
+        );
+
+        result += i == 0 ? "{\"name\": \"" : ", {\"name\": \"";
+        result += name;
+        result += buffer;
+    }
+
+    result += "]";
+    return result;
+}
+
+void PerfCounters::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto* counter : counters) {
+        counter->total = 0;
+        counter->call_cnt = 0;
+    }
+}
+
+void PerfCounters::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // A resident core keeps its static counters, they have to register again with the next game.
+    for (auto* counter : counters) {
+        counter->registered = false;
+        counter->total = 0;
+        counter->call_cnt = 0;
+    }
+    counters.clear();
+}
+
+} //namespace libretrodroid
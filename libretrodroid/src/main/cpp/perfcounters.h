@@ -0,0 +1,86 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_PERFCOUNTERS_H
+#define LIBRETRODROID_PERFCOUNTERS_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../../libretro-common/include/libretro.h"
+#include "utils/threadbinding.h"
+
+namespace libretrodroid {
+
+// Backs RETRO_ENVIRONMENT_GET_PERF_INTERFACE. Counters live in the core memory, we only keep track
+// of the registered ones so that they can be reported. Ticks are CLOCK_MONOTONIC nanoseconds.
+class PerfCounters {
+public:
+    struct Counter {
+        std::string name;
+        uint64_t totalNs;
+        uint64_t calls;
+    };
+
+    using Binding = ThreadBinding<PerfCounters>;
+
+    // Returns the registry bound to the calling thread, or the process wide one.
+    static PerfCounters& getInstance() {
+        PerfCounters* bound = Binding::get();
+        if (bound) return *bound;
+
+        static PerfCounters instance;
+        return instance;
+    }
+    PerfCounters() {}
+    PerfCounters(PerfCounters const&) = delete;
+    void operator=(PerfCounters const&) = delete;
+
+    static void fillCallback(struct retro_perf_callback* callback);
+
+    // Values are sampled while the core might be updating them.
+    std::vector<Counter> getCounters();
+    std::string toJson();
+    void reset();
+
+    // Forgets every counter. Must be called before the core is unloaded.
+    void clear();
+
+private:
+    static retro_time_t callback_get_time_usec();
+    static uint64_t callback_get_cpu_features();
+    static retro_perf_tick_t callback_get_perf_counter();
+    static void callback_perf_register(struct retro_perf_counter* counter);
+    static void callback_perf_start(struct retro_perf_counter* counter);
+    static void callback_perf_stop(struct retro_perf_counter* counter);
+    static void callback_perf_log();
+
+    void registerCounter(struct retro_perf_counter* counter);
+
+private:
+    static constexpr size_t MAX_COUNTERS = 256;
+
+    std::mutex mutex;
+    std::vector<struct retro_perf_counter*> counters;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_PERFCOUNTERS_H
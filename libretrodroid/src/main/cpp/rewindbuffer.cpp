@@ -0,0 +1,249 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "rewindbuffer.h"
+#include "log.h"
+
+namespace libretrodroid {
+
+// Deltas are encoded as a sequence of (unchanged words, changed words, changed words data) tokens,
+// where a word is 8 bytes. Trailing bytes which do not fill a whole word are always stored.
+static constexpr size_t WORD_SIZE = sizeof(uint64_t);
+static constexpr size_t MAX_VARINT_SIZE = 10;
+static constexpr size_t AVERAGE_BYTES_PER_ENTRY = 4096;
+static constexpr size_t MIN_ENTRIES = 16;
+
+static inline uint64_t loadWord(const uint8_t* data, size_t index) {
+    uint64_t result;
+    memcpy(&result, data + index * WORD_SIZE, WORD_SIZE);
+    return result;
+}
+
+static inline void storeWord(uint8_t* data, size_t index, uint64_t value) {
+    memcpy(data + index * WORD_SIZE, &value, WORD_SIZE);
+}
+
+RewindBuffer::RewindBuffer(size_t stateSize, const Config& config) :
+    stateSize(stateSize),
+    frameInterval(std::max(config.frameInterval, 1u)),
+    arena(config.memoryBudget),
+    entries(std::max(config.memoryBudget / AVERAGE_BYTES_PER_ENTRY, MIN_ENTRIES)) {
+
+    LOGI("Initializing rewind buffer with budget %zu bytes and interval %u", config.memoryBudget, frameInterval);
+    reset(stateSize);
+}
+
+void RewindBuffer::reset(size_t newStateSize) {
+    stateSize = newStateSize;
+
+    size_t words = stateSize / WORD_SIZE;
+    size_t maxTokens = words / 2 + 1;
+
+    currentState.resize(stateSize);
+    nextState.resize(stateSize);
+    deltaBuffer.resize(stateSize + maxTokens * 2 * MAX_VARINT_SIZE);
+
+    hasCurrentState = false;
+    framesSinceSnapshot = 0;
+    firstEntry = 0;
+    entriesCount = 0;
+}
+
+bool RewindBuffer::advanceFrame() {
+    if (++framesSinceSnapshot < (int) frameInterval) {
+        return false;
+    }
+
+    framesSinceSnapshot = 0;
+    return true;
+}
+
+std::pair<int8_t*, size_t> RewindBuffer::beginSnapshot() {
+    return std::make_pair(reinterpret_cast<int8_t*>(nextState.data()), stateSize);
+}
+
+void RewindBuffer::commitSnapshot() {
+    if (hasCurrentState) {
+        size_t deltaSize = encodeDelta(currentState.data(), nextState.data());
+        pushEntry(deltaBuffer.data(), deltaSize);
+    }
+
+    std::swap(currentState, nextState);
+    hasCurrentState = true;
+}
+
+std::optional<std::pair<const int8_t*, size_t>> RewindBuffer::rewind(unsigned frames) {
+    if (!hasCurrentState) {
+        return std::nullopt;
+    }
+
+    unsigned steps = std::max((frames + frameInterval - 1) / frameInterval, 1u);
+
+    for (unsigned i = 0; i < steps && entriesCount > 0; i++) {
+        Entry& entry = newest();
+        applyDelta(arena.data() + entry.offset, entry.size, currentState.data());
+        entriesCount--;
+    }
+
+    // The restored state is already the newest snapshot, so we skip one additional frame. This
+    // guarantees progress when the frontend keeps rewinding on every frame.
+    framesSinceSnapshot = -1;
+
+    return std::make_pair(reinterpret_cast<const int8_t*>(currentState.data()), stateSize);
+}
+
+size_t RewindBuffer::getStateSize() const {
+    return stateSize;
+}
+
+unsigned RewindBuffer::getAvailableFrames() const {
+    return entriesCount * frameInterval;
+}
+
+size_t RewindBuffer::encodeDelta(const uint8_t* previous, const uint8_t* current) {
+    size_t words = stateSize / WORD_SIZE;
+    uint8_t* output = deltaBuffer.data();
+
+    size_t i = 0;
+    while (i < words) {
+        size_t unchangedStart = i;
+        while (i < words && loadWord(previous, i) == loadWord(current, i)) i++;
+
+        size_t changedStart = i;
+        while (i < words && loadWord(previous, i) != loadWord(current, i)) i++;
+
+        output = writeVarint(output, changedStart - unchangedStart);
+        output = writeVarint(output, i - changedStart);
+
+        for (size_t j = changedStart; j < i; j++) {
+            storeWord(output, 0, loadWord(previous, j) ^ loadWord(current, j));
+            output += WORD_SIZE;
+        }
+    }
+
+    for (size_t j = words * WORD_SIZE; j < stateSize; j++) {
+        *output++ = previous[j] ^ current[j];
+    }
+
+    return output - deltaBuffer.data();
+}
+
+void RewindBuffer::applyDelta(const uint8_t* delta, size_t size, uint8_t* state) const {
+    size_t words = stateSize / WORD_SIZE;
+    const uint8_t* input = delta;
+
+    size_t i = 0;
+    while (i < words) {
+        size_t unchangedWords;
+        size_t changedWords;
+        input = readVarint(input, unchangedWords);
+        input = readVarint(input, changedWords);
+
+        i += unchangedWords;
+        for (size_t j = 0; j < changedWords; j++, i++) {
+            storeWord(state, i, loadWord(state, i) ^ loadWord(input, 0));
+            input += WORD_SIZE;
+        }
+    }
+
+    for (size_t j = words * WORD_SIZE; j < stateSize; j++) {
+        state[j] ^= *input++;
+    }
+}
+
+void RewindBuffer::pushEntry(const uint8_t* data, size_t size) {
+    if (entriesCount == entries.size()) {
+        evictOldest();
+    }
+
+    auto offset = allocate(size);
+    if (!offset.has_value()) {
+        // Without this delta older entries cannot be reached anymore.
+        LOGW("Rewind snapshot does not fit into the memory budget. Clearing history.");
+        entriesCount = 0;
+        return;
+    }
+
+    memcpy(arena.data() + offset.value(), data, size);
+
+    entries[(firstEntry + entriesCount) % entries.size()] = Entry { offset.value(), size };
+    entriesCount++;
+}
+
+// Entries are laid out contiguously in the arena, which is used as a circular buffer. When the new
+// entry does not fit, we drop the oldest entries until enough contiguous space is available.
+std::optional<size_t> RewindBuffer::allocate(size_t size) {
+    if (size > arena.size()) {
+        return std::nullopt;
+    }
+
+    while (entriesCount > 0) {
+        const Entry& head = oldest();
+        const Entry& tail = newest();
+        size_t writePosition = tail.offset + tail.size;
+
+        if (tail.offset >= head.offset) {
+            if (arena.size() - writePosition >= size) return writePosition;
+            if (head.offset >= size) return 0;
+        } else {
+            if (head.offset - writePosition >= size) return writePosition;
+        }
+
+        evictOldest();
+    }
+
+    firstEntry = 0;
+    return 0;
+}
+
+void RewindBuffer::evictOldest() {
+    firstEntry = (firstEntry + 1) % entries.size();
+    entriesCount--;
+}
+
+RewindBuffer::Entry& RewindBuffer::oldest() {
+    return entries[firstEntry];
+}
+
+RewindBuffer::Entry& RewindBuffer::newest() {
+    return entries[(firstEntry + entriesCount - 1) % entries.size()];
+}
+
+uint8_t* RewindBuffer::writeVarint(uint8_t* output, size_t value) {
+    while (value >= 0x80) {
+        *output++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *output++ = (uint8_t) value;
+    return output;
+}
+
+const uint8_t* RewindBuffer::readVarint(const uint8_t* input, size_t& value) {
+    value = 0;
+    unsigned shift = 0;
+    while (*input & 0x80) {
+        value |= (size_t) (*input++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= (size_t) (*input++) << shift;
+    return input;
+}
+
+} //namespace libretrodroid
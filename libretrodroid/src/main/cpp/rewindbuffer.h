@@ -0,0 +1,93 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBRETRODROID_REWINDBUFFER_H
+#define LIBRETRODROID_REWINDBUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <optional>
+#include <utility>
+
+namespace libretrodroid {
+
+// Keeps a history of save states in a fixed amount of memory. Only the most recent state is stored
+// in full, older ones are stored as run-length encoded XOR deltas against their successor, so that
+// walking back in time only requires applying the deltas from the newest to the oldest.
+class RewindBuffer {
+public:
+    struct Config {
+        size_t memoryBudget = 32 * 1024 * 1024;
+        unsigned frameInterval = 2;
+    };
+
+    RewindBuffer(size_t stateSize, const Config& config);
+
+    // Called once per emulated frame. Returns true when a new snapshot should be captured.
+    bool advanceFrame();
+
+    // Buffer in which the core should serialize the next snapshot, followed by commitSnapshot().
+    std::pair<int8_t*, size_t> beginSnapshot();
+    void commitSnapshot();
+
+    // Walks back in the history by the given amount of frames and returns the state to restore.
+    std::optional<std::pair<const int8_t*, size_t>> rewind(unsigned frames);
+
+    void reset(size_t newStateSize);
+
+    size_t getStateSize() const;
+    unsigned getAvailableFrames() const;
+
+private:
+    struct Entry {
+        size_t offset;
+        size_t size;
+    };
+
+    size_t encodeDelta(const uint8_t* previous, const uint8_t* current);
+    void applyDelta(const uint8_t* delta, size_t size, uint8_t* state) const;
+
+    std::optional<size_t> allocate(size_t size);
+    void pushEntry(const uint8_t* data, size_t size);
+    void evictOldest();
+
+    Entry& oldest();
+    Entry& newest();
+
+    static uint8_t* writeVarint(uint8_t* output, size_t value);
+    static const uint8_t* readVarint(const uint8_t* input, size_t& value);
+
+private:
+    size_t stateSize;
+    unsigned frameInterval;
+    int framesSinceSnapshot = 0;
+
+    bool hasCurrentState = false;
+    std::vector<uint8_t> currentState;
+    std::vector<uint8_t> nextState;
+    std::vector<uint8_t> deltaBuffer;
+
+    std::vector<uint8_t> arena;
+    std::vector<Entry> entries;
+    size_t firstEntry = 0;
+    size_t entriesCount = 0;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_REWINDBUFFER_H
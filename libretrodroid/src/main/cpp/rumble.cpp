@@ -17,21 +17,16 @@
 
 #include "rumble.h"
 #include "log.h"
-#include "environment.h"
 
 namespace libretrodroid {
 
-void Rumble::fetchFromEnvironment() {
-    auto environmentStates = Environment::getInstance().getLastRumbleStates();
-
-    for (int i = 0; i < environmentStates.size(); ++i) {
-        if (rumbleStates[i] == environmentStates[i]) {
-            continue;
-        }
-
-        dirtyStates[i] = true;
-        rumbleStates[i] = environmentStates[i];
+void Rumble::updateState(unsigned port, const RumbleState& state) {
+    if (port >= rumbleStates.size() || rumbleStates[port] == state) {
+        return;
     }
+
+    dirtyStates[port] = true;
+    rumbleStates[port] = state;
 }
 
 void Rumble::handleRumbleUpdates(const std::function<void(int, float, float)>& handler) {
@@ -26,7 +26,8 @@ namespace libretrodroid {
 
 class Rumble {
 public:
-    void fetchFromEnvironment();
+    // Updates are coalesced per port, only the latest state is forwarded to the handler.
+    void updateState(unsigned port, const RumbleState& state);
     void handleRumbleUpdates(const std::function<void(int, float, float)> &handler);
 
 private:
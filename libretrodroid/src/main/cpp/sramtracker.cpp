@@ -0,0 +1,155 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#include "sramtracker.h"
+#include "log.h"
+
+namespace libretrodroid {
+
+static bool writeFullyAt(int fd, const uint8_t* data, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+void SRAMTracker::reset(const uint8_t* data, size_t newSize) {
+    size = newSize;
+    nextPage = 0;
+    dirtyPages = 0;
+    persisted = true;
+
+    persistedData.assign(data, data + size);
+    dirtyFlags.assign(pagesCount(), false);
+}
+
+void SRAMTracker::update(const uint8_t* data, size_t newSize) {
+    if (newSize != size) {
+        LOGI("SRAM size changed to %zu bytes", newSize);
+        reset(data, newSize);
+
+        // Nothing of the new layout has been persisted yet.
+        invalidate();
+        return;
+    }
+
+    size_t pages = pagesCount();
+    if (pages == 0 || !persisted) return;
+
+    for (size_t i = 0; i < std::min(PAGES_PER_FRAME, pages); i++) {
+        size_t page = nextPage;
+        nextPage = (nextPage + 1) % pages;
+
+        bool isDirty = isPageChanged(data, page);
+        if (isDirty == dirtyFlags[page]) continue;
+
+        dirtyFlags[page] = isDirty;
+        if (isDirty) {
+            dirtyPages++;
+        } else {
+            dirtyPages--;
+        }
+    }
+}
+
+bool SRAMTracker::isDirty() const {
+    return dirtyPages > 0;
+}
+
+SRAMTracker::DirtyPages SRAMTracker::takeDirtyPages(const uint8_t* data, size_t newSize, size_t fileSize) {
+    if (newSize != size) {
+        reset(data, newSize);
+        persisted = false;
+    }
+
+    DirtyPages result;
+    result.size = size;
+    result.resize = fileSize != size;
+
+    bool rewriteAll = result.resize || !persisted;
+
+    for (size_t i = 0; i < pagesCount(); i++) {
+        if (!rewriteAll && !isPageChanged(data, i)) continue;
+
+        size_t offset = i * PAGE_SIZE;
+        size_t length = pageLength(i);
+        memcpy(persistedData.data() + offset, data + offset, length);
+        result.data.insert(result.data.end(), data + offset, data + offset + length);
+        result.pages.push_back(i);
+    }
+
+    persisted = true;
+    dirtyPages = 0;
+    dirtyFlags.assign(pagesCount(), false);
+
+    return result;
+}
+
+void SRAMTracker::invalidate() {
+    persisted = false;
+    dirtyPages = pagesCount();
+    dirtyFlags.assign(pagesCount(), true);
+}
+
+bool SRAMTracker::writePages(const DirtyPages& dirtyPages, int fd) {
+    if (dirtyPages.resize && ftruncate(fd, dirtyPages.size) != 0) {
+        LOGE("Cannot resize SRAM file: %s", strerror(errno));
+        return false;
+    }
+
+    const uint8_t* pageData = dirtyPages.data.data();
+    for (size_t page : dirtyPages.pages) {
+        size_t offset = page * PAGE_SIZE;
+        size_t length = std::min(PAGE_SIZE, dirtyPages.size - offset);
+        if (!writeFullyAt(fd, pageData, length, offset)) {
+            LOGE("Cannot write SRAM page %zu: %s", page, strerror(errno));
+            return false;
+        }
+        pageData += length;
+    }
+
+    LOGD("Flushed %zu SRAM pages", dirtyPages.pages.size());
+
+    return fdatasync(fd) == 0;
+}
+
+size_t SRAMTracker::pagesCount() const {
+    return (size + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+size_t SRAMTracker::pageLength(size_t page) const {
+    return std::min(PAGE_SIZE, size - page * PAGE_SIZE);
+}
+
+bool SRAMTracker::isPageChanged(const uint8_t* data, size_t page) const {
+    size_t offset = page * PAGE_SIZE;
+    return memcmp(data + offset, persistedData.data() + offset, pageLength(page)) != 0;
+}
+
+} //namespace libretrodroid
@@ -0,0 +1,81 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_SRAMTRACKER_H
+#define LIBRETRODROID_SRAMTRACKER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace libretrodroid {
+
+// Detects which pages of the save RAM changed since the last flush by comparing them with a copy
+// of the persisted content. Only a few pages are compared on every frame, so that large save
+// memories have a bounded cost.
+class SRAMTracker {
+public:
+    static constexpr size_t PAGE_SIZE = 4096;
+
+    // Pages copied out of the save RAM, which can be written without holding the core.
+    struct DirtyPages {
+        size_t size = 0;
+        bool resize = false;
+        std::vector<size_t> pages;
+        std::vector<uint8_t> data;
+    };
+
+    // Assumes the current content is already persisted.
+    void reset(const uint8_t* data, size_t size);
+
+    // Called at frame boundaries.
+    void update(const uint8_t* data, size_t size);
+
+    // Might lag behind the actual memory content by a few frames.
+    bool isDirty() const;
+
+    // Copies the pages changed since the last flush, and considers them persisted. Files with a
+    // different size are rewritten completely.
+    DirtyPages takeDirtyPages(const uint8_t* data, size_t size, size_t fileSize);
+
+    // Called when the pages returned by takeDirtyPages() could not be written.
+    void invalidate();
+
+    // Writes the pages at their offsets in the file. It only touches the given pages, so it can
+    // run outside the core lock.
+    static bool writePages(const DirtyPages& dirtyPages, int fd);
+
+private:
+    size_t pagesCount() const;
+    size_t pageLength(size_t page) const;
+    bool isPageChanged(const uint8_t* data, size_t page) const;
+
+private:
+    static constexpr size_t PAGES_PER_FRAME = 8;
+
+    size_t size = 0;
+    size_t nextPage = 0;
+    size_t dirtyPages = 0;
+    bool persisted = true;
+    std::vector<uint8_t> persistedData;
+    std::vector<bool> dirtyFlags;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_SRAMTRACKER_H
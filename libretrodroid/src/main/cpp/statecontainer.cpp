@@ -0,0 +1,234 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+#include "statecontainer.h"
+#include "utils/utils.h"
+#include "log.h"
+
+namespace libretrodroid {
+
+static const char MAGIC[4] = { 'L', 'R', 'D', 'S' };
+static const char THUMBNAIL_TAG[4] = { 'T', 'H', 'M', 'B' };
+
+static constexpr uint32_t MAX_STRING_LENGTH = 1024;
+static constexpr uint32_t MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+// Android only runs on little endian architectures, so values are copied as they are.
+template <typename T>
+static void append(std::vector<uint8_t>& output, T value) {
+    size_t offset = output.size();
+    output.resize(offset + sizeof(T));
+    memcpy(output.data() + offset, &value, sizeof(T));
+}
+
+static void appendString(std::vector<uint8_t>& output, const std::string& value) {
+    append<uint32_t>(output, (uint32_t) value.size());
+    output.insert(output.end(), value.begin(), value.end());
+}
+
+template <typename T>
+static bool readValue(int fd, T& value) {
+    return Utils::readFully(fd, &value, sizeof(T));
+}
+
+static bool readString(int fd, std::string& value) {
+    uint32_t length;
+    if (!readValue(fd, length) || length > MAX_STRING_LENGTH) return false;
+
+    value.resize(length);
+    return Utils::readFully(fd, value.data(), length);
+}
+
+static bool writeBlock(int fd, const uint8_t* data, uint32_t size, std::vector<uint8_t>& buffer) {
+    buffer.resize(compressBound(size));
+
+    uLongf compressedSize = buffer.size();
+    int status = compress2(buffer.data(), &compressedSize, data, size, Z_BEST_SPEED);
+
+    bool storeCompressed = status == Z_OK && compressedSize < size;
+    const uint8_t* payload = storeCompressed ? buffer.data() : data;
+    uint32_t payloadSize = storeCompressed ? (uint32_t) compressedSize : size;
+
+    uint32_t blockHeader[3] = { payloadSize, size, (uint32_t) crc32(0, data, size) };
+
+    return Utils::writeFully(fd, blockHeader, sizeof(blockHeader)) &&
+           Utils::writeFully(fd, payload, payloadSize);
+}
+
+static bool readBlock(int fd, uint8_t* data, uint32_t expectedSize, std::vector<uint8_t>& buffer) {
+    uint32_t blockHeader[3];
+    if (!Utils::readFully(fd, blockHeader, sizeof(blockHeader))) return false;
+
+    uint32_t payloadSize = blockHeader[0];
+    uint32_t rawSize = blockHeader[1];
+    uint32_t checksum = blockHeader[2];
+
+    if (rawSize != expectedSize || payloadSize > rawSize) {
+        LOGE("Corrupted state block: unexpected size %u", rawSize);
+        return false;
+    }
+
+    if (payloadSize == rawSize) {
+        if (!Utils::readFully(fd, data, rawSize)) return false;
+    } else {
+        buffer.resize(payloadSize);
+        if (!Utils::readFully(fd, buffer.data(), payloadSize)) return false;
+
+        uLongf decompressedSize = rawSize;
+        int status = uncompress(data, &decompressedSize, buffer.data(), payloadSize);
+        if (status != Z_OK || decompressedSize != rawSize) {
+            LOGE("Corrupted state block: cannot decompress");
+            return false;
+        }
+    }
+
+    if (crc32(0, data, rawSize) != checksum) {
+        LOGE("Corrupted state block: checksum mismatch");
+        return false;
+    }
+
+    return true;
+}
+
+bool StateContainer::write(int fd, const Header& header, const int8_t* state, const Thumbnail* thumbnail) {
+    std::vector<uint8_t> buffer;
+    buffer.insert(buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    append<uint16_t>(buffer, VERSION);
+    append<uint16_t>(buffer, thumbnail != nullptr ? FLAG_THUMBNAIL : 0);
+    append<uint32_t>(buffer, header.apiVersion);
+    appendString(buffer, header.coreName);
+    appendString(buffer, header.coreVersion);
+    append<uint64_t>(buffer, header.stateSize);
+    append<uint32_t>(buffer, header.romCrc);
+    append<uint32_t>(buffer, BLOCK_SIZE);
+
+    if (thumbnail != nullptr) {
+        buffer.insert(buffer.end(), THUMBNAIL_TAG, THUMBNAIL_TAG + sizeof(THUMBNAIL_TAG));
+        append<uint32_t>(buffer, thumbnail->width);
+        append<uint32_t>(buffer, thumbnail->height);
+    }
+
+    if (!Utils::writeFully(fd, buffer.data(), buffer.size())) return false;
+
+    if (thumbnail != nullptr) {
+        auto size = (uint32_t) thumbnail->pixels.size();
+        if (!writeBlock(fd, thumbnail->pixels.data(), size, buffer)) return false;
+    }
+
+    auto* data = reinterpret_cast<const uint8_t*>(state);
+    for (uint64_t offset = 0; offset < header.stateSize; offset += BLOCK_SIZE) {
+        auto size = (uint32_t) std::min<uint64_t>(BLOCK_SIZE, header.stateSize - offset);
+        if (!writeBlock(fd, data + offset, size, buffer)) return false;
+    }
+
+    return true;
+}
+
+StateContainer::Reader::Reader(int fd) : fd(fd) { }
+
+bool StateContainer::Reader::readHeader() {
+    char magic[4];
+    uint16_t version;
+
+    if (!Utils::readFully(fd, magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        LOGE("Invalid state: wrong magic");
+        return false;
+    }
+
+    if (!readValue(fd, version) || version > VERSION) {
+        LOGE("Invalid state: unsupported version");
+        return false;
+    }
+
+    bool result = readValue(fd, flags) &&
+        readValue(fd, header.apiVersion) &&
+        readString(fd, header.coreName) &&
+        readString(fd, header.coreVersion) &&
+        readValue(fd, header.stateSize) &&
+        readValue(fd, header.romCrc) &&
+        readValue(fd, blockSize);
+
+    if (!result || blockSize == 0 || blockSize > MAX_BLOCK_SIZE) {
+        LOGE("Invalid state: truncated or corrupted header");
+        return false;
+    }
+
+    headerRead = true;
+    thumbnailConsumed = (flags & FLAG_THUMBNAIL) == 0;
+    return true;
+}
+
+const StateContainer::Header& StateContainer::Reader::getHeader() const {
+    return header;
+}
+
+std::optional<StateContainer::Thumbnail> StateContainer::Reader::readThumbnail() {
+    if (!headerRead || thumbnailConsumed) {
+        return std::nullopt;
+    }
+    thumbnailConsumed = true;
+
+    char tag[4];
+    Thumbnail result;
+    bool valid = Utils::readFully(fd, tag, sizeof(tag)) &&
+        memcmp(tag, THUMBNAIL_TAG, sizeof(THUMBNAIL_TAG)) == 0 &&
+        readValue(fd, result.width) &&
+        readValue(fd, result.height) &&
+        result.width <= MAX_THUMBNAIL_SIZE &&
+        result.height <= MAX_THUMBNAIL_SIZE;
+
+    if (!valid) {
+        LOGE("Invalid state: corrupted thumbnail");
+        return std::nullopt;
+    }
+
+    result.pixels.resize((size_t) result.width * result.height * 4);
+    if (!readBlock(fd, result.pixels.data(), result.pixels.size(), compressedBuffer)) {
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+bool StateContainer::Reader::skipThumbnail() {
+    return readThumbnail().has_value();
+}
+
+bool StateContainer::Reader::readState(int8_t* data, size_t size) {
+    if (!headerRead || size != header.stateSize) {
+        return false;
+    }
+
+    if (!thumbnailConsumed && !skipThumbnail()) {
+        return false;
+    }
+
+    auto* output = reinterpret_cast<uint8_t*>(data);
+    for (uint64_t offset = 0; offset < header.stateSize; offset += blockSize) {
+        auto expectedSize = (uint32_t) std::min<uint64_t>(blockSize, header.stateSize - offset);
+        if (!readBlock(fd, output + offset, expectedSize, compressedBuffer)) return false;
+    }
+
+    return true;
+}
+
+} //namespace libretrodroid
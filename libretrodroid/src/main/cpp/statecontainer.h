@@ -0,0 +1,97 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_STATECONTAINER_H
+#define LIBRETRODROID_STATECONTAINER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace libretrodroid {
+
+// Save state file format. A header identifies the core and the game which produced the state, an
+// optional thumbnail follows, then the state split in independently compressed blocks, each one
+// with a crc32 of its uncompressed content.
+//
+// All the integers are stored in little endian:
+//   "LRDS" | u16 version | u16 flags | u32 api version | u32 len, core name | u32 len, core version
+//   u64 state size | u32 rom crc32 | u32 block size
+//   ["THMB" | u32 width | u32 height | block]                   when FLAG_THUMBNAIL is set
+//   block*                                                      until state size is reached
+// where block is: u32 stored size | u32 raw size | u32 crc32 | data. Blocks are stored uncompressed
+// when the stored size is equal to the raw size.
+class StateContainer {
+public:
+    struct Header {
+        unsigned apiVersion = 0;
+        std::string coreName;
+        std::string coreVersion;
+        uint64_t stateSize = 0;
+        uint32_t romCrc = 0;
+    };
+
+    // Pixels are tightly packed RGBA8888.
+    struct Thumbnail {
+        unsigned width = 0;
+        unsigned height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    // Compresses one block at a time, so only a block sized buffer is needed on top of the state.
+    static bool write(int fd, const Header& header, const int8_t* state, const Thumbnail* thumbnail);
+
+    // Sequential reader. The header is parsed first, so that incompatible states are rejected
+    // before decompressing them.
+    class Reader {
+    public:
+        explicit Reader(int fd);
+
+        bool readHeader();
+        const Header& getHeader() const;
+
+        // Returns an empty result if the container has no thumbnail.
+        std::optional<Thumbnail> readThumbnail();
+
+        // Decompresses the state directly into the given memory, which must hold stateSize bytes.
+        bool readState(int8_t* data, size_t size);
+
+    private:
+        bool skipThumbnail();
+
+    private:
+        int fd;
+        Header header;
+        uint16_t flags = 0;
+        uint32_t blockSize = 0;
+        bool headerRead = false;
+        bool thumbnailConsumed = false;
+        std::vector<uint8_t> compressedBuffer;
+    };
+
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint16_t FLAG_THUMBNAIL = 1 << 0;
+    static constexpr uint32_t BLOCK_SIZE = 256 * 1024;
+    static constexpr uint32_t MAX_THUMBNAIL_SIZE = 4096;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_STATECONTAINER_H
@@ -0,0 +1,119 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#include "statewriter.h"
+#include "log.h"
+
+namespace libretrodroid {
+
+StateWriter::StateWriter() {
+    worker = std::thread([this]() { run(); });
+}
+
+StateWriter::~StateWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    condition.notify_all();
+    worker.join();
+}
+
+std::vector<int8_t> StateWriter::acquireBuffer(size_t size) {
+    std::vector<int8_t> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeBuffers.empty()) {
+            result = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+
+    result.resize(size);
+    return result;
+}
+
+void StateWriter::releaseBuffer(std::vector<int8_t> buffer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeBuffers.size() < MAX_POOLED_BUFFERS) {
+        freeBuffers.push_back(std::move(buffer));
+    }
+}
+
+void StateWriter::submit(
+    std::vector<int8_t> state,
+    StateContainer::Header header,
+    std::optional<StateContainer::Thumbnail> thumbnail,
+    int fd,
+    Callback callback
+) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(Job {
+            std::move(state),
+            std::move(header),
+            std::move(thumbnail),
+            fd,
+            std::move(callback)
+        });
+    }
+    condition.notify_one();
+}
+
+// Pending jobs are always completed before the thread exits, so no save is lost on destroy.
+void StateWriter::run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopped || !jobs.empty(); });
+
+            if (jobs.empty()) return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        bool result = write(job);
+        if (close(job.fd) != 0) {
+            result = false;
+        }
+
+        if (!result) {
+            LOGE("Error while writing save state: %s", strerror(errno));
+        }
+
+        releaseBuffer(std::move(job.state));
+
+        if (job.callback) {
+            job.callback(result);
+        }
+    }
+}
+
+bool StateWriter::write(const Job& job) {
+    const StateContainer::Thumbnail* thumbnail = job.thumbnail.has_value() ? &job.thumbnail.value() : nullptr;
+
+    return StateContainer::write(job.fd, job.header, job.state.data(), thumbnail) && fsync(job.fd) == 0;
+}
+
+} //namespace libretrodroid
@@ -0,0 +1,85 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_STATEWRITER_H
+#define LIBRETRODROID_STATEWRITER_H
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "statecontainer.h"
+
+namespace libretrodroid {
+
+// Encodes save states into containers and writes them to file descriptors on a background thread. The caller
+// only pays for retro_serialize() into a pooled buffer, which is returned to the pool once written.
+class StateWriter {
+public:
+    typedef std::function<void(bool)> Callback;
+
+    StateWriter();
+    ~StateWriter();
+
+    StateWriter(StateWriter const&) = delete;
+    void operator=(StateWriter const&) = delete;
+
+    std::vector<int8_t> acquireBuffer(size_t size);
+
+    // Takes ownership of the file descriptor. The callback is invoked on the worker thread.
+    void submit(
+        std::vector<int8_t> state,
+        StateContainer::Header header,
+        std::optional<StateContainer::Thumbnail> thumbnail,
+        int fd,
+        Callback callback
+    );
+
+private:
+    struct Job {
+        std::vector<int8_t> state;
+        StateContainer::Header header;
+        std::optional<StateContainer::Thumbnail> thumbnail;
+        int fd;
+        Callback callback;
+    };
+
+    void run();
+    bool write(const Job& job);
+    void releaseBuffer(std::vector<int8_t> buffer);
+
+private:
+    static constexpr size_t MAX_POOLED_BUFFERS = 2;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Job> jobs;
+    std::vector<std::vector<int8_t>> freeBuffers;
+    bool stopped = false;
+
+    std::thread worker;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_STATEWRITER_H
@@ -0,0 +1,455 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Synthetic libretro core used to benchmark and test the frontend without third party cores or
+// commercial content. Everything it produces is a deterministic function of the frame counter and
+// of the input, so two runs with the same input are bit-identical. Its behaviour is controlled
+// through core options which are read when the game is loaded.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "libretro.h"
+
+namespace {
+
+constexpr unsigned SRAM_SIZE = 8 * 1024;
+constexpr unsigned STATE_HEADER_SIZE = 32;
+constexpr unsigned STATE_WRITES_PER_FRAME = 64;
+constexpr uint32_t STATE_MAGIC = 0x54534554; // "TEST"
+
+constexpr const char* OPTION_RESOLUTION = "testcore_resolution";
+constexpr const char* OPTION_PIXEL_FORMAT = "testcore_pixel_format";
+constexpr const char* OPTION_PITCH_PADDING = "testcore_pitch_padding";
+constexpr const char* OPTION_FPS = "testcore_fps";
+constexpr const char* OPTION_AUDIO_RATE = "testcore_audio_rate";
+constexpr const char* OPTION_STATE_SIZE = "testcore_state_size";
+constexpr const char* OPTION_HW_RENDER = "testcore_hw_render";
+
+const struct retro_variable VARIABLES[] = {
+    { OPTION_RESOLUTION, "Resolution; 320x240|256x224|640x480|1280x720|1920x1080" },
+    { OPTION_PIXEL_FORMAT, "Pixel format; rgb565|xrgb8888|0rgb1555" },
+    { OPTION_PITCH_PADDING, "Pitch padding in bytes; 0|16|64|256" },
+    { OPTION_FPS, "Frame rate; 60|59.94|50|30" },
+    { OPTION_AUDIO_RATE, "Audio sample rate; 48000|44100|32000|22050|0" },
+    { OPTION_STATE_SIZE, "Save state size in bytes; 65536|1024|262144|1048576|4194304|0" },
+    { OPTION_HW_RENDER, "Hardware rendering; disabled|enabled" },
+    { nullptr, nullptr },
+};
+
+struct Config {
+    unsigned width = 320;
+    unsigned height = 240;
+    retro_pixel_format pixelFormat = RETRO_PIXEL_FORMAT_RGB565;
+    unsigned pitchPadding = 0;
+    double fps = 60.0;
+    double audioRate = 48000.0;
+    size_t stateSize = 65536;
+    bool hwRender = false;
+};
+
+typedef void (*GLClearColorProc)(float, float, float, float);
+typedef void (*GLClearProc)(unsigned int);
+typedef void (*GLBindFramebufferProc)(unsigned int, unsigned int);
+typedef void (*GLViewportProc)(int, int, int, int);
+
+constexpr unsigned int GL_FRAMEBUFFER = 0x8D40;
+constexpr unsigned int GL_COLOR_BUFFER_BIT = 0x00004000;
+
+struct GLFunctions {
+    GLClearColorProc clearColor = nullptr;
+    GLClearProc clear = nullptr;
+    GLBindFramebufferProc bindFramebuffer = nullptr;
+    GLViewportProc viewport = nullptr;
+};
+
+retro_environment_t environ_cb = nullptr;
+retro_video_refresh_t video_cb = nullptr;
+retro_audio_sample_t audio_cb = nullptr;
+retro_audio_sample_batch_t audio_batch_cb = nullptr;
+retro_input_poll_t input_poll_cb = nullptr;
+retro_input_state_t input_state_cb = nullptr;
+
+Config config;
+retro_hw_render_callback hw_render {};
+GLFunctions gl;
+
+std::vector<uint8_t> frameBuffer;
+std::vector<int16_t> audioBuffer;
+std::vector<uint8_t> state;
+uint8_t sram[SRAM_SIZE];
+
+// The emulated machine is fully described by these fields and the state buffer.
+uint64_t frameCounter = 0;
+uint64_t audioSampleCounter = 0;
+uint32_t randomState = 1;
+uint16_t lastInput = 0;
+
+const char* getOption(const char* key, const char* fallback) {
+    struct retro_variable variable { key, nullptr };
+    if (environ_cb && environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &variable) && variable.value) {
+        return variable.value;
+    }
+    return fallback;
+}
+
+void loadConfig() {
+    config = Config {};
+
+    std::string resolution = getOption(OPTION_RESOLUTION, "320x240");
+    auto separator = resolution.find('x');
+    if (separator != std::string::npos) {
+        config.width = std::max(1, std::atoi(resolution.substr(0, separator).c_str()));
+        config.height = std::max(1, std::atoi(resolution.substr(separator + 1).c_str()));
+    }
+
+    std::string pixelFormat = getOption(OPTION_PIXEL_FORMAT, "rgb565");
+    if (pixelFormat == "xrgb8888") {
+        config.pixelFormat = RETRO_PIXEL_FORMAT_XRGB8888;
+    } else if (pixelFormat == "0rgb1555") {
+        config.pixelFormat = RETRO_PIXEL_FORMAT_0RGB1555;
+    }
+
+    config.pitchPadding = std::atoi(getOption(OPTION_PITCH_PADDING, "0"));
+    config.fps = std::max(1.0, std::atof(getOption(OPTION_FPS, "60")));
+    config.audioRate = std::max(0.0, std::atof(getOption(OPTION_AUDIO_RATE, "48000")));
+    config.stateSize = std::strtoul(getOption(OPTION_STATE_SIZE, "65536"), nullptr, 10);
+    config.hwRender = std::string(getOption(OPTION_HW_RENDER, "disabled")) == "enabled";
+
+    if (config.stateSize > 0 && config.stateSize < STATE_HEADER_SIZE) {
+        config.stateSize = STATE_HEADER_SIZE;
+    }
+}
+
+unsigned getBytesPerPixel() {
+    return config.pixelFormat == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2;
+}
+
+size_t getPitch() {
+    return config.width * getBytesPerPixel() + config.pitchPadding;
+}
+
+uint32_t nextRandom() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+void writeHeader() {
+    uint32_t magic = STATE_MAGIC;
+    memcpy(state.data(), &magic, sizeof(magic));
+    memcpy(state.data() + 4, &randomState, sizeof(randomState));
+    memcpy(state.data() + 8, &frameCounter, sizeof(frameCounter));
+    memcpy(state.data() + 16, &audioSampleCounter, sizeof(audioSampleCounter));
+    memcpy(state.data() + 24, &lastInput, sizeof(lastInput));
+}
+
+bool readHeader(const uint8_t* data) {
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    if (magic != STATE_MAGIC) return false;
+
+    memcpy(&randomState, data + 4, sizeof(randomState));
+    memcpy(&frameCounter, data + 8, sizeof(frameCounter));
+    memcpy(&audioSampleCounter, data + 16, sizeof(audioSampleCounter));
+    memcpy(&lastInput, data + 24, sizeof(lastInput));
+    return true;
+}
+
+uint16_t pollInput() {
+    input_poll_cb();
+
+    uint16_t result = 0;
+    for (unsigned id = 0; id <= RETRO_DEVICE_ID_JOYPAD_R3; id++) {
+        if (input_state_cb(0, RETRO_DEVICE_JOYPAD, 0, id)) {
+            result |= 1 << id;
+        }
+    }
+    return result;
+}
+
+// Mutates a handful of bytes of the state, similar to what the RAM of a real system does.
+void updateState() {
+    if (config.stateSize == 0) return;
+
+    size_t bodySize = config.stateSize - STATE_HEADER_SIZE;
+    for (unsigned i = 0; bodySize > 0 && i < STATE_WRITES_PER_FRAME; i++) {
+        uint32_t value = nextRandom();
+        state[STATE_HEADER_SIZE + value % bodySize] = (uint8_t) ((value >> 24) ^ lastInput);
+    }
+
+    if (frameCounter % 60 == 0) {
+        sram[nextRandom() % SRAM_SIZE] = (uint8_t) frameCounter;
+    }
+}
+
+template <typename T>
+void fillFrame(T (*color)(unsigned, unsigned, unsigned)) {
+    size_t pitch = getPitch();
+    auto offset = (unsigned) (frameCounter + lastInput);
+
+    for (unsigned y = 0; y < config.height; y++) {
+        T* line = reinterpret_cast<T*>(frameBuffer.data() + y * pitch);
+        for (unsigned x = 0; x < config.width; x++) {
+            line[x] = color(x + offset, y, offset);
+        }
+    }
+}
+
+uint16_t colorRGB565(unsigned x, unsigned y, unsigned offset) {
+    return (uint16_t) (((x & 0x1F) << 11) | ((y & 0x3F) << 5) | ((x ^ y ^ offset) & 0x1F));
+}
+
+uint16_t color0RGB1555(unsigned x, unsigned y, unsigned offset) {
+    return (uint16_t) (((x & 0x1F) << 10) | ((y & 0x1F) << 5) | ((x ^ y ^ offset) & 0x1F));
+}
+
+uint32_t colorXRGB8888(unsigned x, unsigned y, unsigned offset) {
+    return ((x & 0xFF) << 16) | ((y & 0xFF) << 8) | ((x ^ y ^ offset) & 0xFF);
+}
+
+void renderSoftwareFrame() {
+    switch (config.pixelFormat) {
+        case RETRO_PIXEL_FORMAT_XRGB8888:
+            fillFrame<uint32_t>(&colorXRGB8888);
+            break;
+        case RETRO_PIXEL_FORMAT_0RGB1555:
+            fillFrame<uint16_t>(&color0RGB1555);
+            break;
+        default:
+            fillFrame<uint16_t>(&colorRGB565);
+            break;
+    }
+
+    video_cb(frameBuffer.data(), config.width, config.height, getPitch());
+}
+
+void renderHardwareFrame() {
+    if (gl.bindFramebuffer == nullptr) {
+        video_cb(nullptr, config.width, config.height, 0);
+        return;
+    }
+
+    float phase = (float) (frameCounter % 256) / 255.0f;
+    gl.bindFramebuffer(GL_FRAMEBUFFER, (unsigned int) hw_render.get_current_framebuffer());
+    gl.viewport(0, 0, (int) config.width, (int) config.height);
+    gl.clearColor(phase, 1.0f - phase, (float) (lastInput & 0xFF) / 255.0f, 1.0f);
+    gl.clear(GL_COLOR_BUFFER_BIT);
+
+    video_cb(RETRO_HW_FRAME_BUFFER_VALID, config.width, config.height, 0);
+}
+
+void renderAudio() {
+    if (config.audioRate <= 0) return;
+
+    // Integer sample positions are derived from the frame counter, so the amount of samples per
+    // frame averages exactly to audioRate / fps.
+    auto expectedSamples = (uint64_t) std::llround((double) (frameCounter + 1) * config.audioRate / config.fps);
+    size_t frames = expectedSamples > audioSampleCounter ? expectedSamples - audioSampleCounter : 0;
+
+    audioBuffer.resize(frames * 2);
+    for (size_t i = 0; i < frames; i++) {
+        uint64_t sample = audioSampleCounter + i;
+        auto value = (int16_t) ((sample / 64) % 2 == 0 ? 4096 : -4096);
+        audioBuffer[i * 2] = value;
+        audioBuffer[i * 2 + 1] = value;
+    }
+    audioSampleCounter += frames;
+
+    // The frontend may accept only part of the batch. When it stops accepting samples, for
+    // example because audio is disabled, the rest of the frame is dropped.
+    size_t written = 0;
+    while (written < frames) {
+        size_t result = audio_batch_cb(audioBuffer.data() + written * 2, frames - written);
+        if (result == 0) break;
+        written += result;
+    }
+}
+
+void contextReset() {
+    gl.clearColor = (GLClearColorProc) hw_render.get_proc_address("glClearColor");
+    gl.clear = (GLClearProc) hw_render.get_proc_address("glClear");
+    gl.bindFramebuffer = (GLBindFramebufferProc) hw_render.get_proc_address("glBindFramebuffer");
+    gl.viewport = (GLViewportProc) hw_render.get_proc_address("glViewport");
+}
+
+void contextDestroy() {
+    gl = GLFunctions {};
+}
+
+} //namespace
+
+RETRO_API void retro_set_environment(retro_environment_t cb) {
+    environ_cb = cb;
+
+    bool noGame = true;
+    environ_cb(RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME, &noGame);
+    environ_cb(RETRO_ENVIRONMENT_SET_VARIABLES, (void*) VARIABLES);
+}
+
+RETRO_API void retro_set_video_refresh(retro_video_refresh_t cb) { video_cb = cb; }
+RETRO_API void retro_set_audio_sample(retro_audio_sample_t cb) { audio_cb = cb; }
+RETRO_API void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb) { audio_batch_cb = cb; }
+RETRO_API void retro_set_input_poll(retro_input_poll_t cb) { input_poll_cb = cb; }
+RETRO_API void retro_set_input_state(retro_input_state_t cb) { input_state_cb = cb; }
+
+RETRO_API void retro_init(void) {
+    frameCounter = 0;
+    audioSampleCounter = 0;
+    randomState = 1;
+    lastInput = 0;
+    memset(sram, 0, sizeof(sram));
+}
+
+RETRO_API void retro_deinit(void) {
+    frameBuffer = std::vector<uint8_t>();
+    audioBuffer = std::vector<int16_t>();
+    state = std::vector<uint8_t>();
+}
+
+RETRO_API unsigned retro_api_version(void) {
+    return RETRO_API_VERSION;
+}
+
+RETRO_API void retro_get_system_info(struct retro_system_info* info) {
+    memset(info, 0, sizeof(*info));
+    info->library_name = "LibretroDroid Test Core";
+    info->library_version = "1.0";
+    info->valid_extensions = "";
+    info->need_fullpath = false;
+    info->block_extract = false;
+}
+
+RETRO_API void retro_get_system_av_info(struct retro_system_av_info* info) {
+    info->geometry.base_width = config.width;
+    info->geometry.base_height = config.height;
+    info->geometry.max_width = config.width;
+    info->geometry.max_height = config.height;
+    info->geometry.aspect_ratio = (float) config.width / (float) config.height;
+    info->timing.fps = config.fps;
+    info->timing.sample_rate = config.audioRate > 0 ? config.audioRate : 48000.0;
+}
+
+RETRO_API void retro_set_controller_port_device(unsigned port, unsigned device) { }
+
+RETRO_API void retro_reset(void) {
+    retro_init();
+    std::fill(state.begin(), state.end(), 0);
+}
+
+RETRO_API void retro_run(void) {
+    lastInput = pollInput();
+    updateState();
+
+    int audioVideoEnable = 3;
+    if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &audioVideoEnable)) {
+        audioVideoEnable = 3;
+    }
+
+    if (audioVideoEnable & 1) {
+        config.hwRender ? renderHardwareFrame() : renderSoftwareFrame();
+    } else {
+        video_cb(nullptr, config.width, config.height, 0);
+    }
+
+    if (audioVideoEnable & 2) {
+        renderAudio();
+    } else {
+        // Audio is skipped but the timeline has to stay consistent.
+        audioSampleCounter = (uint64_t) std::llround((double) (frameCounter + 1) * config.audioRate / config.fps);
+    }
+
+    frameCounter++;
+}
+
+RETRO_API size_t retro_serialize_size(void) {
+    return config.stateSize;
+}
+
+RETRO_API bool retro_serialize(void* data, size_t size) {
+    if (config.stateSize == 0 || size < config.stateSize) return false;
+
+    writeHeader();
+    memcpy(data, state.data(), config.stateSize);
+    return true;
+}
+
+RETRO_API bool retro_unserialize(const void* data, size_t size) {
+    if (config.stateSize == 0 || size < config.stateSize) return false;
+
+    auto bytes = static_cast<const uint8_t*>(data);
+    if (!readHeader(bytes)) return false;
+
+    memcpy(state.data(), bytes, config.stateSize);
+    return true;
+}
+
+RETRO_API void retro_cheat_reset(void) { }
+RETRO_API void retro_cheat_set(unsigned index, bool enabled, const char* code) { }
+
+RETRO_API bool retro_load_game(const struct retro_game_info* game) {
+    loadConfig();
+
+    enum retro_pixel_format pixelFormat = config.pixelFormat;
+    if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &pixelFormat)) {
+        return false;
+    }
+
+    if (config.hwRender) {
+        hw_render = retro_hw_render_callback {};
+        hw_render.context_type = RETRO_HW_CONTEXT_OPENGLES3;
+        hw_render.context_reset = &contextReset;
+        hw_render.context_destroy = &contextDestroy;
+        hw_render.bottom_left_origin = true;
+
+        if (!environ_cb(RETRO_ENVIRONMENT_SET_HW_RENDER, &hw_render)) {
+            return false;
+        }
+    }
+
+    frameBuffer.assign(getPitch() * config.height, 0);
+    state.assign(config.stateSize, 0);
+    return true;
+}
+
+RETRO_API bool retro_load_game_special(unsigned type, const struct retro_game_info* info, size_t num) {
+    return false;
+}
+
+RETRO_API void retro_unload_game(void) {
+    frameBuffer.clear();
+    state.clear();
+}
+
+RETRO_API unsigned retro_get_region(void) {
+    return RETRO_REGION_NTSC;
+}
+
+RETRO_API void* retro_get_memory_data(unsigned id) {
+    return id == RETRO_MEMORY_SAVE_RAM ? sram : nullptr;
+}
+
+RETRO_API size_t retro_get_memory_size(unsigned id) {
+    return id == RETRO_MEMORY_SAVE_RAM ? SRAM_SIZE : 0;
+}
@@ -17,6 +17,7 @@
 
 #include "javautils.h"
 #include "jnistring.h"
+#include "../log.h"
 
 namespace libretrodroid {
 
@@ -88,6 +89,25 @@ std::unordered_map<std::string, std::string> JavaUtils::stringMapFromJava(JNIEnv
     return result;
 }
 
+void JavaUtils::withAttachedThread(JavaVM* vm, const std::function<void(JNIEnv*)> &lambda) {
+    JNIEnv* env = nullptr;
+    bool attached = false;
+
+    if (vm->GetEnv((void**) &env, JNI_VERSION_1_6) != JNI_OK) {
+        if (vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+            LOGE("Cannot attach thread to the Java VM");
+            return;
+        }
+        attached = true;
+    }
+
+    lambda(env);
+
+    if (attached) {
+        vm->DetachCurrentThread();
+    }
+}
+
 ShaderManager::Config JavaUtils::shaderFromJava(JNIEnv *env, jobject obj) {
     jclass jShaderClass = env->FindClass("com/swordfish/libretrodroid/GLRetroShader");
 
@@ -102,4 +122,32 @@ ShaderManager::Config JavaUtils::shaderFromJava(JNIEnv *env, jobject obj) {
     return ShaderManager::Config { ShaderManager::Type(type), params };
 }
 
+StateContainer::Thumbnail JavaUtils::thumbnailFromJava(JNIEnv* env, jobject obj) {
+    jclass jThumbnailClass = env->FindClass("com/swordfish/libretrodroid/StateThumbnail");
+
+    jfieldID jWidthField = env->GetFieldID(jThumbnailClass, "width", "I");
+    jfieldID jHeightField = env->GetFieldID(jThumbnailClass, "height", "I");
+    jfieldID jPixelsField = env->GetFieldID(jThumbnailClass, "pixels", "[B");
+
+    StateContainer::Thumbnail result;
+    result.width = env->GetIntField(obj, jWidthField);
+    result.height = env->GetIntField(obj, jHeightField);
+
+    auto jPixels = (jbyteArray) env->GetObjectField(obj, jPixelsField);
+    jsize size = env->GetArrayLength(jPixels);
+
+    if (result.width > StateContainer::MAX_THUMBNAIL_SIZE || result.height > StateContainer::MAX_THUMBNAIL_SIZE) {
+        throw std::runtime_error("Thumbnail is too large");
+    }
+
+    if ((size_t) size != (size_t) result.width * result.height * 4) {
+        throw std::runtime_error("Thumbnail pixels do not match its size");
+    }
+
+    result.pixels.resize(size);
+    env->GetByteArrayRegion(jPixels, 0, size, (jbyte*) result.pixels.data());
+
+    return result;
+}
+
 } //namespace libretrodroid
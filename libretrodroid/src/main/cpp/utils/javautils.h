@@ -24,6 +24,7 @@
 #include <jni.h>
 #include "../environment.h"
 #include "../shadermanager.h"
+#include "../statecontainer.h"
 
 namespace libretrodroid {
 
@@ -32,10 +33,14 @@ public:
     // Conversion from LibretroDroid types
     static Variable variableFromJava(JNIEnv* env, jobject obj);
     static ShaderManager::Config shaderFromJava(JNIEnv* env, jobject obj);
+    static StateContainer::Thumbnail thumbnailFromJava(JNIEnv* env, jobject obj);
 
     static jint throwRetroException(JNIEnv* env, int errorCode);
     static void forEachOnJavaIterable(JNIEnv* env, jobject jList, const std::function<void(jobject)> &lambda);
     static std::unordered_map<std::string, std::string> stringMapFromJava(JNIEnv* env, jobject jMap);
+
+    // Runs the lambda with a valid JNIEnv, attaching the current thread to the VM only if needed.
+    static void withAttachedThread(JavaVM* vm, const std::function<void(JNIEnv*)> &lambda);
 };
 
 }
@@ -0,0 +1,132 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mappedfile.h"
+#include "utils.h"
+#include "../log.h"
+
+namespace libretrodroid {
+
+// Only the beginning of the game is read ahead, the rest is paged in when the core accesses it.
+static constexpr size_t READ_AHEAD_SIZE = 4 * 1024 * 1024;
+
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+// Pipes and sockets do not report their size, so they are read until the end.
+static bool readUntilEnd(int fileDescriptor, std::vector<uint8_t>& data) {
+    size_t size = 0;
+    while (true) {
+        data.resize(size + READ_CHUNK_SIZE);
+        ssize_t result = read(fileDescriptor, data.data() + size, READ_CHUNK_SIZE);
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0) return false;
+        if (result == 0) break;
+        size += result;
+    }
+    data.resize(size);
+    return true;
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& path) {
+    int fileDescriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor < 0) {
+        LOGE("Cannot open file %s: %s", path.c_str(), strerror(errno));
+        throw std::runtime_error("Cannot open game file");
+    }
+    return open(fileDescriptor);
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(int fileDescriptor) {
+    std::unique_ptr<MappedFile> result(new MappedFile());
+
+    struct stat fileStat {};
+    if (fstat(fileDescriptor, &fileStat) != 0) {
+        close(fileDescriptor);
+        throw std::runtime_error("Cannot stat game file");
+    }
+
+    if (!S_ISREG(fileStat.st_mode)) {
+        bool success = readUntilEnd(fileDescriptor, result->fallbackData);
+        close(fileDescriptor);
+        if (!success || result->fallbackData.empty()) {
+            LOGE("Cannot read game file: %s", success ? "empty stream" : strerror(errno));
+            throw std::runtime_error("Cannot read game file");
+        }
+        result->size = result->fallbackData.size();
+        return result;
+    }
+
+    result->size = fileStat.st_size;
+
+    // Some cores patch the game in place, so pages must be writable. MAP_PRIVATE keeps those
+    // changes in memory and only the modified pages are copied.
+    if (result->size > 0) {
+        void* mapping = mmap(
+            nullptr,
+            result->size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE,
+            fileDescriptor,
+            0
+        );
+
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, result->size, MADV_SEQUENTIAL);
+            madvise(mapping, std::min(result->size, READ_AHEAD_SIZE), MADV_WILLNEED);
+            result->mapping = mapping;
+        } else {
+            LOGW("Cannot map game file, falling back to read: %s", strerror(errno));
+        }
+    }
+
+    if (result->mapping == nullptr && result->size > 0) {
+        result->fallbackData.resize(result->size);
+        if (!Utils::readFully(fileDescriptor, result->fallbackData.data(), result->size)) {
+            close(fileDescriptor);
+            throw std::runtime_error("Cannot read game file");
+        }
+    }
+
+    close(fileDescriptor);
+    return result;
+}
+
+MappedFile::~MappedFile() {
+    if (mapping != nullptr) {
+        munmap(mapping, size);
+    }
+}
+
+const void* MappedFile::getData() const {
+    return mapping != nullptr ? mapping : fallbackData.data();
+}
+
+size_t MappedFile::getSize() const {
+    return size;
+}
+
+} //namespace libretrodroid
@@ -0,0 +1,58 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_MAPPEDFILE_H
+#define LIBRETRODROID_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace libretrodroid {
+
+// Maps a whole file in memory, so that large games are paged in on demand instead of being copied
+// in the heap. Files which cannot be mapped are read in a regular buffer, pipes until their end.
+class MappedFile {
+public:
+    static std::unique_ptr<MappedFile> open(const std::string& path);
+
+    // The file descriptor is closed, the mapping stays valid until this object is destroyed.
+    static std::unique_ptr<MappedFile> open(int fileDescriptor);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    void operator=(MappedFile const&) = delete;
+
+    const void* getData() const;
+    size_t getSize() const;
+
+private:
+    MappedFile() = default;
+
+private:
+    void* mapping = nullptr;
+    size_t size = 0;
+    std::vector<uint8_t> fallbackData;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_MAPPEDFILE_H
@@ -0,0 +1,58 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_THREADBINDING_H
+#define LIBRETRODROID_THREADBINDING_H
+
+namespace libretrodroid {
+
+// Libretro callbacks do not carry any user data, so the objects serving them are looked up through
+// the calling thread. A thread running a core binds its own instances for as long as it calls into
+// it, which lets several sessions share the same process. Callbacks issued by threads spawned by
+// the core are not bound and end up on the process wide instances.
+template <typename T>
+class ThreadBinding {
+public:
+    static T* get() {
+        return current;
+    }
+
+    class Scope {
+    public:
+        explicit Scope(T* value): previous(current) {
+            current = value;
+        }
+
+        ~Scope() {
+            current = previous;
+        }
+
+        Scope(Scope const&) = delete;
+        void operator=(Scope const&) = delete;
+
+    private:
+        T* previous;
+    };
+
+private:
+    static inline thread_local T* current = nullptr;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_THREADBINDING_H
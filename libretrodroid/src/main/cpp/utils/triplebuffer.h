@@ -0,0 +1,68 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBRETRODROID_TRIPLEBUFFER_H
+#define LIBRETRODROID_TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace libretrodroid {
+
+// Lock-free single producer, single consumer mailbox. The producer always has a buffer to write
+// into and the consumer always reads the most recently published one, older ones are dropped.
+template <typename T>
+class TripleBuffer {
+public:
+    T& getWriteBuffer() {
+        return buffers[writeIndex];
+    }
+
+    void publish() {
+        uint8_t previous = middle.exchange(writeIndex | DIRTY_BIT, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Returns true if a new buffer has been published since the last call.
+    bool consume() {
+        if ((middle.load(std::memory_order_relaxed) & DIRTY_BIT) == 0) {
+            return false;
+        }
+
+        uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    T& getReadBuffer() {
+        return buffers[readIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t DIRTY_BIT = 0x4;
+
+    std::array<T, 3> buffers;
+    std::atomic<uint8_t> middle { 1 };
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 2;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_TRIPLEBUFFER_H
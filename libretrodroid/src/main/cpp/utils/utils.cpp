@@ -15,9 +15,11 @@
  *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <cerrno>
 #include <iostream>
 #include <fstream>
 #include <unistd.h>
+#include <cstring>
 
 #include "utils.h"
 #include "../log.h"
@@ -54,6 +56,32 @@ size_t Utils::getFileSize(FILE* file) {
     return size;
 }
 
+bool Utils::writeFully(int fileDescriptor, const void* data, size_t size) {
+    auto* current = (const uint8_t*) data;
+    while (size > 0) {
+        ssize_t written = write(fileDescriptor, current, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+
+        current += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool Utils::readFully(int fileDescriptor, void* data, size_t size) {
+    auto* current = (uint8_t*) data;
+    while (size > 0) {
+        ssize_t bytesRead = read(fileDescriptor, current, size);
+        if (bytesRead < 0 && errno == EINTR) continue;
+        if (bytesRead <= 0) return false;
+
+        current += bytesRead;
+        size -= bytesRead;
+    }
+    return true;
+}
+
 const char* Utils::cloneToCString(const std::string &input) {
     char* result = new char[input.length() + 1];
     std::strcpy(result, input.c_str());
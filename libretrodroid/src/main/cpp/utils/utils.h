@@ -33,6 +33,10 @@ public:
     static const char* cloneToCString(const std::string &input);
 
     static size_t getFileSize(FILE* file);
+
+    // Handle partial transfers and interrupted calls. Return false on errors or end of file.
+    static bool writeFully(int fileDescriptor, const void* data, size_t size);
+    static bool readFully(int fileDescriptor, void* data, size_t size);
 };
 
 }
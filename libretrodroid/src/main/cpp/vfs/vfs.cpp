@@ -19,6 +19,7 @@
 
 #include <unistd.h>
 #include <optional>
+#include <cstring>
 
 #include "vfs/vfs_implementation.h"
 #include "../log.h"
@@ -23,6 +23,7 @@
 #include "libretro.h"
 #include "vfs.h"
 #include "vfsfile.h"
+#include "../utils/threadbinding.h"
 
 #include <vector>
 #include <string>
@@ -34,11 +35,18 @@ namespace libretrodroid {
 class VFS {
 public:
     static const int SUPPORTED_VERSION = 2;
+    using Binding = ThreadBinding<VFS>;
+
+    // Returns the file system bound to the calling thread, or the process wide one.
     static VFS& getInstance()
     {
+        VFS* bound = Binding::get();
+        if (bound) return *bound;
+
         static VFS instance;
         return instance;
     }
+    VFS() {}
     VFS(VFS const&) = delete;
     void operator=(VFS const&) = delete;
 
@@ -47,8 +55,6 @@ public:
     void deinitialize();
 
 private:
-    VFS() {}
-
     struct retro_vfs_file_handle* virtualOpen(const char *path, unsigned mode, unsigned hints);
 
     VFSFile* findVirtualFile(const char* path);
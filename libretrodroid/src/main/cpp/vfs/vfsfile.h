@@ -19,6 +19,7 @@
 #define LIBRETRODROID_VFSFILE_H
 
 #include <string>
+#include <memory>
 
 #include "fdwrapper.h"
 
@@ -29,6 +29,7 @@
 #include "renderers/es3/framebufferrenderer.h"
 #include "renderers/es3/imagerendereres3.h"
 #include "renderers/es2/imagerendereres2.h"
+#include "frametimings.h"
 
 namespace libretrodroid {
 
@@ -148,6 +149,7 @@ void Video::renderFrame() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (immersiveModeEnabled) {
+        ScopedTiming timing(FrameTimings::PHASE_IMMERSIVE_BACKGROUND);
         immersiveMode.renderBackground(
             videoLayout.getScreenWidth(),
             videoLayout.getScreenHeight(),
@@ -160,6 +162,8 @@ void Video::renderFrame() {
 
     updateProgram();
     for (int i = 0; i < shadersChain.size(); ++i) {
+        ScopedTiming timing(FrameTimings::shaderPass(i));
+
         auto shader = shadersChain[i];
         auto passData = renderer->getPassData(i);
         auto isLastPass = i == shadersChain.size() - 1;
@@ -227,6 +231,7 @@ float Video::getTextureHeight() {
 
 void Video::onNewFrame(const void *data, unsigned width, unsigned height, size_t pitch) {
     if (data != nullptr) {
+        ScopedTiming timing(FrameTimings::PHASE_FRAME_UPLOAD);
         renderer->onNewFrame(data, width, height, pitch);
         isDirty = true;
     }
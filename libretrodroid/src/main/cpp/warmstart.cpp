@@ -0,0 +1,88 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cstdio>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "warmstart.h"
+
+namespace libretrodroid {
+
+static uLong crcString(uLong crc, const std::string& value) {
+    crc = crc32(crc, (const Bytef*) value.data(), value.size());
+    return crc32(crc, (const Bytef*) "\0", 1);
+}
+
+WarmStart::WarmStart(const Config& config, std::string gameIdentity) :
+    bootFrames(std::max(config.bootFrames, 1u)),
+    snapshotDirectory(config.snapshotDirectory),
+    gameIdentity(std::move(gameIdentity)) {
+
+    mkdir(snapshotDirectory.c_str(), 0700);
+}
+
+const std::string& WarmStart::prepare(const StateContainer::Header& header, const int8_t* sram, size_t sramSize) {
+    uLong identityCrc = crc32(0, nullptr, 0);
+    identityCrc = crcString(identityCrc, header.coreName);
+    identityCrc = crcString(identityCrc, header.coreVersion);
+    identityCrc = crcString(identityCrc, gameIdentity);
+
+    uLong sramCrc = crc32(0, nullptr, 0);
+    if (sram != nullptr) {
+        sramCrc = crc32(sramCrc, (const Bytef*) sram, sramSize);
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%08lx-%08lx.lrds", identityCrc, sramCrc);
+
+    snapshotPath = snapshotDirectory + "/" + name;
+    prepared = true;
+
+    return snapshotPath;
+}
+
+bool WarmStart::isPrepared() const {
+    return prepared;
+}
+
+const std::string& WarmStart::getSnapshotPath() const {
+    return snapshotPath;
+}
+
+void WarmStart::startRecording() {
+    remainingFrames = bootFrames;
+}
+
+void WarmStart::cancelRecording() {
+    remainingFrames = 0;
+}
+
+bool WarmStart::isRecording() const {
+    return remainingFrames > 0;
+}
+
+bool WarmStart::advanceFrame() {
+    if (remainingFrames == 0) {
+        return false;
+    }
+    return --remainingFrames == 0;
+}
+
+} //namespace libretrodroid
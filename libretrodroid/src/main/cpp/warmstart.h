@@ -0,0 +1,66 @@
+/*
+ *     Copyright (C) 2026  Filippo Scognamiglio
+ *
+ *     This program is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBRETRODROID_WARMSTART_H
+#define LIBRETRODROID_WARMSTART_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#include "statecontainer.h"
+
+namespace libretrodroid {
+
+// Keeps track of the boot snapshot of a game. The first launch records a save state after the
+// boot sequence, while the following ones restore it before running the first frame.
+class WarmStart {
+public:
+    struct Config {
+        bool keepCoreLoaded = false;
+        std::string snapshotDirectory;
+        unsigned bootFrames = 600;
+    };
+
+    WarmStart(const Config& config, std::string gameIdentity);
+
+    // Must be called before the first frame, after the save RAM has been restored. Games often read
+    // it while booting, so it takes part in the snapshot identity.
+    const std::string& prepare(const StateContainer::Header& header, const int8_t* sram, size_t sramSize);
+    bool isPrepared() const;
+    const std::string& getSnapshotPath() const;
+
+    void startRecording();
+    void cancelRecording();
+    bool isRecording() const;
+
+    // Returns true on the frame after which the boot snapshot should be recorded.
+    bool advanceFrame();
+
+private:
+    unsigned bootFrames;
+    std::string snapshotDirectory;
+    std::string gameIdentity;
+    std::string snapshotPath;
+    unsigned remainingFrames = 0;
+    bool prepared = false;
+};
+
+} //namespace libretrodroid
+
+#endif //LIBRETRODROID_WARMSTART_H
@@ -0,0 +1,6 @@
+package com.swordfish.libretrodroid
+
+/**
+ * Represents a message the core asked to show to the user. Higher priority messages should
+ * replace lower priority ones which are still on screen. */
+data class CoreMessage(val message: String, val durationMs: Int, val priority: Int)
@@ -0,0 +1,13 @@
+package com.swordfish.libretrodroid
+
+/**
+ * Frame pacing accuracy measured by the native frame limiter. Errors are expressed in microseconds
+ * and measure how far from its deadline each frame has been released.
+ */
+data class FrameTimingStats(
+    val frames: Long,
+    val lateFrames: Long,
+    val meanErrorMicros: Double,
+    val rmsErrorMicros: Double,
+    val maxErrorMicros: Double
+)
@@ -22,6 +22,7 @@ import android.content.Context
 import android.graphics.PointF
 import android.graphics.RectF
 import android.opengl.GLSurfaceView
+import android.os.ParcelFileDescriptor
 import android.util.Log
 import android.view.InputDevice
 import android.view.KeyEvent
@@ -34,15 +35,22 @@ import androidx.lifecycle.OnLifecycleEvent
 import androidx.lifecycle.coroutineScope
 import com.swordfish.libretrodroid.KtUtils.awaitUninterruptibly
 import com.swordfish.libretrodroid.gamepad.GamepadsManager
+import java.io.File
+import java.nio.ByteBuffer
 import java.util.*
 import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+import kotlin.coroutines.resume
+import kotlin.coroutines.suspendCoroutine
 import javax.microedition.khronos.egl.EGLConfig
 import javax.microedition.khronos.opengles.GL10
 import kotlin.properties.Delegates
+import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.GlobalScope
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.MutableSharedFlow
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
 
 class GLRetroView(
     context: Context,
@@ -57,6 +65,19 @@ class GLRetroView(
         LibretroDroid.setFrameSpeed(value)
     }
 
+    var runAheadFrames: Int by Delegates.observable(0) { _, _, value ->
+        LibretroDroid.setRunAheadFrames(value)
+    }
+
+    /**
+     * Skips drawing frames when the device falls behind the content frame rate or the audio buffer
+     * is about to run out, so that audio keeps playing without glitches. At most three frames are
+     * skipped in a row.
+     */
+    var adaptiveFrameSkip: Boolean by Delegates.observable(false) { _, _, value ->
+        LibretroDroid.setAdaptiveFrameSkip(value)
+    }
+
     var shader: ShaderConfig by Delegates.observable(data.shader) { _, _, value ->
         LibretroDroid.setShaderConfig(buildShader(value))
     }
@@ -77,6 +98,7 @@ class GLRetroView(
     private val retroGLIssuesErrors = MutableSharedFlow<Int>(1)
 
     private val rumbleEventsSubject = MutableSharedFlow<RumbleEvent>()
+    private val messageEventsSubject = MutableSharedFlow<CoreMessage>()
 
     private var lifecycle: Lifecycle? = null
 
@@ -103,7 +125,11 @@ class GLRetroView(
             data.gameVirtualFiles.isNotEmpty(),
             data.enableMicrophone,
             data.skipDuplicateFrames,
+            data.threadedEmulation,
+            data.precisePacing,
             data.immersiveMode,
+            data.rewind,
+            data.warmStart,
             getDeviceLanguage()
         )
         LibretroDroid.setRumbleEnabled(data.rumbleEventsEnabled)
@@ -121,12 +147,20 @@ class GLRetroView(
         return (context.getSystemService(Context.WINDOW_SERVICE) as WindowManager).defaultDisplay.refreshRate
     }
 
-    fun sendKeyEvent(action: Int, keyCode: Int, port: Int = 0) {
-        queueEvent { LibretroDroid.onKeyEvent(port, action, keyCode) }
+    /** The event time is only used to trace input latency. It's expressed in the System.nanoTime() base. */
+    fun sendKeyEvent(action: Int, keyCode: Int, port: Int = 0, eventTimeNanos: Long = System.nanoTime()) {
+        queueEvent { LibretroDroid.onKeyEvent(port, action, keyCode, eventTimeNanos) }
     }
 
-    fun sendMotionEvent(source: Int, xAxis: Float, yAxis: Float, port: Int = 0) {
-        queueEvent { LibretroDroid.onMotionEvent(port, source, xAxis, yAxis) }
+    /** The event time is only used to trace input latency. It's expressed in the System.nanoTime() base. */
+    fun sendMotionEvent(
+        source: Int,
+        xAxis: Float,
+        yAxis: Float,
+        port: Int = 0,
+        eventTimeNanos: Long = System.nanoTime()
+    ) {
+        queueEvent { LibretroDroid.onMotionEvent(port, source, xAxis, yAxis, eventTimeNanos) }
     }
 
     override fun onTouchEvent(event: MotionEvent?): Boolean {
@@ -143,7 +177,7 @@ class GLRetroView(
         }
 
         if (position != null) {
-            LibretroDroid.onTouchEvent(position.x, position.y)
+            LibretroDroid.onTouchEvent(position.x, position.y, toNanos(event.eventTime))
         }
 
         return true
@@ -151,6 +185,11 @@ class GLRetroView(
 
     private fun clamp(x: Float, min: Float, max: Float) = minOf(maxOf(x, min), max)
 
+    // Android event times use the uptimeMillis() clock, which shares its base with System.nanoTime().
+    // getEventTimeNanos() requires API 34, so the events of this view are only precise to the
+    // millisecond. Callers needing more precision can pass their own times to sendKeyEvent().
+    private fun toNanos(eventTimeMillis: Long) = TimeUnit.MILLISECONDS.toNanos(eventTimeMillis)
+
     private fun normalizeTouchCoordinates(x: Float, y: Float): PointF {
         val x = clamp(2f * x / width - 1f, -1f, +1f)
         val y = clamp(2f * y / height - 1f, -1f, +1f)
@@ -175,6 +214,123 @@ class GLRetroView(
         }
     }
 
+    /**
+     * Writes a compressed save state container into the given file. The emulation is only blocked
+     * while the core serializes, compression and disk access happen in background. Ownership of
+     * the file descriptor is transferred to the native side.
+     */
+    suspend fun saveStateAsync(
+        fileDescriptor: ParcelFileDescriptor,
+        thumbnail: StateThumbnail? = null,
+        useEmulationThread: Boolean = true
+    ): Boolean = suspendCoroutine { continuation ->
+        val fd = fileDescriptor.detachFd()
+        val saveState = {
+            try {
+                LibretroDroid.saveStateAsync(fd, thumbnail) { continuation.resume(it) }
+            } catch (e: RetroException) {
+                continuation.resume(false)
+            }
+        }
+
+        // The continuation is resumed by the native callback, so the caller is never blocked.
+        if (useEmulationThread) {
+            queueEvent { saveState() }
+        } else {
+            saveState()
+        }
+    }
+
+    /**
+     * Loads a state written by [saveStateAsync]. States created by a different core or for a
+     * different game are rejected before touching the running emulation. Decompression runs on
+     * [Dispatchers.IO], the emulation is only blocked while the core restores the state.
+     */
+    suspend fun loadState(fileDescriptor: ParcelFileDescriptor): Boolean = withContext(Dispatchers.IO) {
+        LibretroDroid.loadState(fileDescriptor.fd)
+    }
+
+    /**
+     * Opens a deduplicating store for save states in the given directory. Slots mostly share their
+     * content, so each distinct chunk of data is only kept once on disk. Like all the other store
+     * functions, the disk access runs on [Dispatchers.IO] and the emulation is only blocked while
+     * the core serializes or restores the state.
+     */
+    suspend fun openStateStore(directory: File): Boolean = withContext(Dispatchers.IO) {
+        LibretroDroid.openStateStore(directory.absolutePath)
+    }
+
+    /**
+     * Stores the current state in the given slot. Slot names can contain letters, digits, '_', '-'
+     * and '.'.
+     */
+    suspend fun saveStateToStore(slot: String): Boolean = withContext(Dispatchers.IO) {
+        LibretroDroid.saveStateToStore(slot)
+    }
+
+    suspend fun loadStateFromStore(slot: String): Boolean = withContext(Dispatchers.IO) {
+        LibretroDroid.loadStateFromStore(slot)
+    }
+
+    suspend fun deleteStateFromStore(slot: String): Boolean = withContext(Dispatchers.IO) {
+        LibretroDroid.deleteStateFromStore(slot)
+    }
+
+    suspend fun getStoreSlots(): List<String> = withContext(Dispatchers.IO) {
+        LibretroDroid.getStoreSlots().toList()
+    }
+
+    /** Frees the space used by deleted or overwritten slots. Returns the number of removed chunks. */
+    suspend fun collectStoreGarbage(): Int = withContext(Dispatchers.IO) {
+        LibretroDroid.collectStoreGarbage()
+    }
+
+    fun getSerializeSize(useEmulationThread: Boolean = true): Int {
+        return runOnEmulationThread(useEmulationThread) {
+            LibretroDroid.getSerializeSize()
+        }
+    }
+
+    /**
+     * Serializes the state straight into a direct [ByteBuffer] of at least [getSerializeSize]
+     * bytes, avoiding intermediate copies. Returns the number of bytes written.
+     */
+    fun serializeState(buffer: ByteBuffer, useEmulationThread: Boolean = true): Int {
+        return runOnEmulationThread(useEmulationThread) {
+            LibretroDroid.serializeStateToBuffer(buffer)
+        }
+    }
+
+    fun unserializeState(buffer: ByteBuffer, size: Int, useEmulationThread: Boolean = true): Boolean {
+        return runOnEmulationThread(useEmulationThread) {
+            LibretroDroid.unserializeStateFromBuffer(buffer, size)
+        }
+    }
+
+    /**
+     * Direct view over the core save RAM, or null if the core has none. The buffer is only valid
+     * until the game is unloaded and it should be accessed on the emulation thread.
+     */
+    fun getSRAMBuffer(useEmulationThread: Boolean = true): ByteBuffer? {
+        return runOnEmulationThread(useEmulationThread) {
+            LibretroDroid.getSRAMBuffer()
+        }
+    }
+
+    /** Cheap check which tells if the save RAM changed since it was loaded or last flushed. */
+    fun isSRAMDirty(): Boolean {
+        return LibretroDroid.isSRAMDirty()
+    }
+
+    /**
+     * Writes only the modified pages of the save RAM into the given file, which should contain the
+     * previously loaded or flushed content. Mismatching files are rewritten completely. The disk
+     * access runs on [Dispatchers.IO], the emulation is only blocked while the pages are copied.
+     */
+    suspend fun flushSRAM(fileDescriptor: ParcelFileDescriptor): Boolean = withContext(Dispatchers.IO) {
+        LibretroDroid.flushSRAM(fileDescriptor.fd)
+    }
+
     fun serializeSRAM(useEmulationThread: Boolean = true): ByteArray {
         return runOnEmulationThread(useEmulationThread) {
             LibretroDroid.serializeSRAM()
@@ -191,6 +347,84 @@ class GLRetroView(
         LibretroDroid.reset()
     }
 
+    fun rewind(frames: Int = 1, useEmulationThread: Boolean = true): Boolean {
+        return runOnEmulationThread(useEmulationThread) {
+            LibretroDroid.rewind(frames)
+        }
+    }
+
+    /**
+     * Records every input read by the core, starting from the current state, into the given file.
+     * Replaying it with [startMoviePlayback] reproduces the session frame by frame. Run-ahead and
+     * rewind are disabled until [stopMovie] is called. Ownership of the file descriptor is
+     * transferred to the native side.
+     */
+    fun startMovieRecording(fileDescriptor: ParcelFileDescriptor, useEmulationThread: Boolean = true): Boolean {
+        val fd = fileDescriptor.detachFd()
+        return runOnEmulationThread(useEmulationThread) {
+            LibretroDroid.startMovieRecording(fd)
+        }
+    }
+
+    /**
+     * Restores the state a movie was recorded from and feeds its inputs to the core. Live input
+     * is used again once the movie ends. Ownership of the file descriptor is transferred to the
+     * native side.
+     */
+    fun startMoviePlayback(fileDescriptor: ParcelFileDescriptor, useEmulationThread: Boolean = true): Boolean {
+        val fd = fileDescriptor.detachFd()
+        return runOnEmulationThread(useEmulationThread) {
+            LibretroDroid.startMoviePlayback(fd)
+        }
+    }
+
+    /** Stops the current movie. Returns false if a recording could not be completely written. */
+    fun stopMovie(useEmulationThread: Boolean = true): Boolean {
+        return runOnEmulationThread(useEmulationThread) {
+            LibretroDroid.stopMovie()
+        }
+    }
+
+    fun getFrameTimingStats(): FrameTimingStats? {
+        return LibretroDroid.getFrameTimingStats()
+    }
+
+    fun resetFrameTimingStats() {
+        LibretroDroid.resetFrameTimingStats()
+    }
+
+    fun getPerfCounters(): Array<PerfCounter> {
+        return LibretroDroid.getPerfCounters()
+    }
+
+    fun resetPerfCounters() {
+        LibretroDroid.resetPerfCounters()
+    }
+
+    fun setPhaseTimingsEnabled(enabled: Boolean) {
+        LibretroDroid.setPhaseTimingsEnabled(enabled)
+    }
+
+    fun getPhaseTimings(): Array<PhaseTimingStats> {
+        return LibretroDroid.getPhaseTimings()
+    }
+
+    fun resetPhaseTimings() {
+        LibretroDroid.resetPhaseTimings()
+    }
+
+    fun setInputLatencyTracingEnabled(enabled: Boolean) {
+        LibretroDroid.setInputLatencyTracingEnabled(enabled)
+    }
+
+    fun getInputLatencyStats(): InputLatencyStats {
+        return LibretroDroid.getInputLatencyStats()
+    }
+
+    fun resetInputLatencyStats() {
+        LibretroDroid.resetInputLatencyStats()
+    }
+
     fun getGLRetroEvents(): Flow<GLRetroEvents> {
         return retroGLEventsSubject
     }
@@ -203,6 +437,10 @@ class GLRetroView(
         return rumbleEventsSubject
     }
 
+    fun getMessageEvents(): Flow<CoreMessage> {
+        return messageEventsSubject
+    }
+
     fun getControllers(): Array<Array<Controller>> {
         return LibretroDroid.getControllers()
     }
@@ -247,7 +485,7 @@ class GLRetroView(
         val port = (event?.device?.controllerNumber ?: 0) - 1
 
         if (event != null && port >= 0 && keyCode in GamepadsManager.GAMEPAD_KEYS) {
-            sendKeyEvent(KeyEvent.ACTION_DOWN, mappedKey, port)
+            sendKeyEvent(KeyEvent.ACTION_DOWN, mappedKey, port, toNanos(event.eventTime))
             return true
         }
         return super.onKeyDown(keyCode, event)
@@ -258,7 +496,7 @@ class GLRetroView(
         val port = (event?.device?.controllerNumber ?: 0) - 1
 
         if (event != null && port >= 0 && keyCode in GamepadsManager.GAMEPAD_KEYS) {
-            sendKeyEvent(KeyEvent.ACTION_UP, mappedKey, port)
+            sendKeyEvent(KeyEvent.ACTION_UP, mappedKey, port, toNanos(event.eventTime))
             return true
         }
         return super.onKeyUp(keyCode, event)
@@ -273,19 +511,22 @@ class GLRetroView(
                         MOTION_SOURCE_DPAD,
                         event.getAxisValue(MotionEvent.AXIS_HAT_X),
                         event.getAxisValue(MotionEvent.AXIS_HAT_Y),
-                        port
+                        port,
+                        toNanos(event.eventTime)
                     )
                     sendMotionEvent(
                         MOTION_SOURCE_ANALOG_LEFT,
                         event.getAxisValue(MotionEvent.AXIS_X),
                         event.getAxisValue(MotionEvent.AXIS_Y),
-                        port
+                        port,
+                        toNanos(event.eventTime)
                     )
                     sendMotionEvent(
                         MOTION_SOURCE_ANALOG_RIGHT,
                         event.getAxisValue(MotionEvent.AXIS_Z),
                         event.getAxisValue(MotionEvent.AXIS_RZ),
-                        port
+                        port,
+                        toNanos(event.eventTime)
                     )
                 }
             }
@@ -341,6 +582,7 @@ class GLRetroView(
         when {
             data.gameFilePath != null -> loadGameFromPath(data.gameFilePath!!)
             data.gameFileBytes != null -> loadGameFromBytes(data.gameFileBytes!!)
+            data.gameFileBuffer != null -> loadGameFromBuffer(data.gameFileBuffer!!)
             data.gameVirtualFiles.isNotEmpty() -> loadGameFromVirtualFiles(data.gameVirtualFiles)
         }
         data.saveRAMState?.let {
@@ -365,6 +607,10 @@ class GLRetroView(
         LibretroDroid.loadGameFromBytes(gameFileBytes)
     }
 
+    private fun loadGameFromBuffer(gameFileBuffer: ByteBuffer) {
+        LibretroDroid.loadGameFromBuffer(gameFileBuffer)
+    }
+
     private fun loadGameFromPath(gameFilePath: String) {
         LibretroDroid.loadGameFromPath(gameFilePath)
     }
@@ -399,7 +645,8 @@ class GLRetroView(
         }
 
         latch.awaitUninterruptibly()
-        return result!!
+        @Suppress("UNCHECKED_CAST")
+        return result as T
     }
 
     private fun buildShader(config: ShaderConfig): GLRetroShader {
@@ -487,6 +734,13 @@ class GLRetroView(
         }
     }
 
+    /** This function gets called from the jni side.*/
+    private fun sendMessageEvent(message: String, durationMs: Int, priority: Int) {
+        lifecycle?.coroutineScope?.launch {
+            messageEventsSubject.emit(CoreMessage(message, durationMs, priority))
+        }
+    }
+
     private fun refreshAspectRatio() {
         runOnEmulationThread(true) {
             LibretroDroid.refreshAspectRatio()
@@ -501,6 +755,11 @@ class GLRetroView(
     companion object {
         private val TAG_LOG = GLRetroView::class.java.simpleName
 
+        /** Reads the thumbnail of a save state container without decoding the state. */
+        fun readStateThumbnail(fileDescriptor: ParcelFileDescriptor): StateThumbnail? {
+            return LibretroDroid.readStateThumbnail(fileDescriptor.fd)
+        }
+
         const val MOTION_SOURCE_DPAD = LibretroDroid.MOTION_SOURCE_DPAD
         const val MOTION_SOURCE_ANALOG_LEFT = LibretroDroid.MOTION_SOURCE_ANALOG_LEFT
         const val MOTION_SOURCE_ANALOG_RIGHT = LibretroDroid.MOTION_SOURCE_ANALOG_RIGHT
@@ -18,11 +18,15 @@
 package com.swordfish.libretrodroid
 
 import android.content.Context
+import java.nio.ByteBuffer
 
 class GLRetroViewData(context: Context) {
     var coreFilePath: String? = null
     var gameFilePath: String? = null
     var gameFileBytes: ByteArray? = null
+
+    /** Direct buffer used in place as game content, it must not be modified while running. */
+    var gameFileBuffer: ByteBuffer? = null
     var gameVirtualFiles: List<VirtualFile> = listOf()
     var systemDirectory: String = context.filesDir.absolutePath
     var savesDirectory: String = context.filesDir.absolutePath
@@ -32,6 +36,10 @@ class GLRetroViewData(context: Context) {
     var rumbleEventsEnabled: Boolean = true
     var preferLowLatencyAudio: Boolean = true
     var skipDuplicateFrames: Boolean = false
+    var threadedEmulation: Boolean = false
+    var precisePacing: Boolean = false
     var enableMicrophone: Boolean = false
     var immersiveMode: ImmersiveMode? = null
+    var rewind: RewindConfig? = null
+    var warmStart: WarmStartConfig? = null
 }
@@ -0,0 +1,22 @@
+package com.swordfish.libretrodroid
+
+/**
+ * Latency of the input events, measured from the Android event time. [toRead] ends when the core
+ * first reads the port the event changed, [toPresent] when the frame produced with it is drawn.
+ */
+data class InputLatencyStats(
+    val toRead: LatencyDistribution,
+    val toPresent: LatencyDistribution
+)
+
+/**
+ * Distribution of the last samples, values are expressed in microseconds. Events forwarded by
+ * [GLRetroView] carry millisecond timestamps, so values can be up to one millisecond too high.
+ */
+data class LatencyDistribution(
+    val samples: Int,
+    val minMicros: Long,
+    val p50Micros: Long,
+    val p95Micros: Long,
+    val maxMicros: Long
+)
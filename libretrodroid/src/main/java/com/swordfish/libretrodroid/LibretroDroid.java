@@ -17,6 +17,7 @@
 
 package com.swordfish.libretrodroid;
 
+import java.nio.ByteBuffer;
 import java.util.List;
 
 public class LibretroDroid {
@@ -90,12 +91,17 @@ public class LibretroDroid {
         boolean enableVirtualFileSystem,
         boolean enableMicrophone,
         boolean skipDuplicateFrames,
+        boolean threadedEmulation,
+        boolean precisePacing,
         ImmersiveMode immersiveMode,
+        RewindConfig rewindConfig,
+        WarmStartConfig warmStartConfig,
         String language
     );
 
     public static native void loadGameFromPath(String gameFilePath);
     public static native void loadGameFromBytes(byte[] gameFileBytes);
+    public static native void loadGameFromBuffer(ByteBuffer gameFileBuffer);
     public static native void loadGameFromVirtualFiles(List<DetachedVirtualFile> virtualFiles);
     public static native void resume();
 
@@ -109,8 +115,38 @@ public class LibretroDroid {
 
     public static native void reset();
 
+    public static native void saveStateAsync(int fd, StateThumbnail thumbnail, SaveStateCallback callback);
+    public static native boolean loadState(int fd);
+    public static native StateThumbnail readStateThumbnail(int fd);
+
+    public static native boolean openStateStore(String directory);
+    public static native boolean saveStateToStore(String slot);
+    public static native boolean loadStateFromStore(String slot);
+    public static native boolean deleteStateFromStore(String slot);
+    public static native String[] getStoreSlots();
+    public static native int collectStoreGarbage();
+
+    public static native boolean rewind(int frames);
+
+    public static native boolean startMovieRecording(int fd);
+    public static native boolean startMoviePlayback(int fd);
+    public static native boolean stopMovie();
+
     public static native void setRumbleEnabled(boolean enabled);
     public static native void setFrameSpeed(int speed);
+    public static native void setRunAheadFrames(int frames);
+
+    public static native void setAdaptiveFrameSkip(boolean enabled);
+    public static native FrameTimingStats getFrameTimingStats();
+    public static native void resetFrameTimingStats();
+    public static native PerfCounter[] getPerfCounters();
+    public static native void resetPerfCounters();
+    public static native void setPhaseTimingsEnabled(boolean enabled);
+    public static native PhaseTimingStats[] getPhaseTimings();
+    public static native void resetPhaseTimings();
+    public static native void setInputLatencyTracingEnabled(boolean enabled);
+    public static native InputLatencyStats getInputLatencyStats();
+    public static native void resetInputLatencyStats();
     public static native void setAudioEnabled(boolean enabled);
     public static native void setShaderConfig(GLRetroShader shader);
     public static native void setViewport(float x, float y, float width, float height);
@@ -118,11 +154,18 @@ public class LibretroDroid {
     public static native byte[] serializeState();
     public static native boolean unserializeState(byte[] state);
 
+    public static native int getSerializeSize();
+    public static native int serializeStateToBuffer(ByteBuffer buffer);
+    public static native boolean unserializeStateFromBuffer(ByteBuffer buffer, int size);
+
     public static native void setCheat(int index, boolean enable, String code);
     public static native void resetCheat();
 
     public static native byte[] serializeSRAM();
     public static native boolean unserializeSRAM(byte[] sram);
+    public static native ByteBuffer getSRAMBuffer();
+    public static native boolean isSRAMDirty();
+    public static native boolean flushSRAM(int fd);
 
     public static native void updateVariable(Variable variable);
     public static native Variable[] getVariables();
@@ -131,10 +174,10 @@ public class LibretroDroid {
     public static native int currentDisk();
     public static native void changeDisk(int index);
 
-    public static native void onMotionEvent(int port, int motionSource, float xAxis, float yAxis);
-    public static native void onTouchEvent(float xAxis, float yAxis);
+    public static native void onMotionEvent(int port, int motionSource, float xAxis, float yAxis, long eventTime);
+    public static native void onTouchEvent(float xAxis, float yAxis, long eventTime);
 
-    public static native void onKeyEvent(int port, int action, int keyCode);
+    public static native void onKeyEvent(int port, int action, int keyCode, long eventTime);
 
     public static native void refreshAspectRatio();
 
@@ -0,0 +1,11 @@
+package com.swordfish.libretrodroid
+
+/**
+ * A counter registered by the core through the libretro perf interface. It measures the total time
+ * spent in an instrumented section and how many times it was entered.
+ */
+data class PerfCounter(
+    val name: String,
+    val totalNanos: Long,
+    val calls: Long
+)
@@ -0,0 +1,21 @@
+package com.swordfish.libretrodroid
+
+/**
+ * Rolling duration statistics of a phase of the frame, computed over the last samples. Durations
+ * are expressed in microseconds. Rendering phases measure the time spent submitting GL commands.
+ */
+data class PhaseTimingStats(
+    val phase: String,
+    val samples: Int,
+    val minMicros: Long,
+    val p50Micros: Long,
+    val p95Micros: Long,
+    val maxMicros: Long
+) {
+    companion object {
+        const val PHASE_RETRO_RUN = "retro_run"
+        const val PHASE_FRAME_UPLOAD = "frame_upload"
+        const val PHASE_IMMERSIVE_BACKGROUND = "immersive_background"
+        const val PHASE_FPS_WAIT = "fps_wait"
+    }
+}
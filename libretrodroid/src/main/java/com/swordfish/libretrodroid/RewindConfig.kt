@@ -0,0 +1,6 @@
+package com.swordfish.libretrodroid
+
+data class RewindConfig(
+    val memoryBudget: Long = 32L * 1024 * 1024,
+    val frameInterval: Int = 2
+)
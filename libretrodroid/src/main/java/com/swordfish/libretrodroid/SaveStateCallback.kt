@@ -0,0 +1,6 @@
+package com.swordfish.libretrodroid
+
+/** Invoked from a background thread once an asynchronous save state has been written. */
+fun interface SaveStateCallback {
+    fun onComplete(success: Boolean)
+}
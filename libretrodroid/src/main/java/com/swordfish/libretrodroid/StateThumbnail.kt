@@ -0,0 +1,8 @@
+package com.swordfish.libretrodroid
+
+/** Preview stored along a save state. Pixels are tightly packed RGBA8888, up to 4096x4096. */
+class StateThumbnail(
+    val width: Int,
+    val height: Int,
+    val pixels: ByteArray
+)
@@ -0,0 +1,17 @@
+package com.swordfish.libretrodroid
+
+/**
+ * Reduces the time needed to reach the first interactive frame.
+ *
+ * @param keepCoreLoaded keeps the core library loaded after the view is destroyed, so that the
+ * next session using the same core skips loading it. Only enable it for cores which correctly
+ * reinitialize after retro_deinit.
+ * @param snapshotDirectory where boot snapshots are stored. When set, the first launch of a game
+ * records a save state after [bootFrames] frames, and following launches restore it immediately.
+ * @param bootFrames number of frames emulated before recording the boot snapshot.
+ */
+data class WarmStartConfig(
+    val keepCoreLoaded: Boolean = false,
+    val snapshotDirectory: String? = null,
+    val bootFrames: Int = 600
+)